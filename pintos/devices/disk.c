@@ -2,11 +2,13 @@
 #include <ctype.h>
 #include <debug.h>
 #include <stdbool.h>
+#include <stats.h>
 #include <stdio.h>
 #include "devices/timer.h"
 #include "threads/io.h"
 #include "threads/interrupt.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 /* The code in this file is an interface to an ATA (IDE)
    controller.  It attempts to comply to [ATA-3]. */
@@ -173,6 +175,22 @@ disk_print_stats (void) {
 	}
 }
 
+/* Fills in the per-disk sector counts of ST. */
+void
+disk_get_stats (struct sys_stats *st) {
+	int chan_no;
+
+	for (chan_no = 0; chan_no < CHANNEL_CNT; chan_no++) {
+		int dev_no;
+
+		for (dev_no = 0; dev_no < 2; dev_no++) {
+			struct disk *d = &channels[chan_no].devices[dev_no];
+			st->disk_reads[chan_no * 2 + dev_no] = d->read_cnt;
+			st->disk_writes[chan_no * 2 + dev_no] = d->write_cnt;
+		}
+	}
+}
+
 /* Returns the disk numbered DEV_NO--either 0 or 1 for master or
    slave, respectively--within the channel numbered CHAN_NO.
 
@@ -215,6 +233,7 @@ disk_read (struct disk *d, disk_sector_t sec_no, void *buffer) {
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
+	TRACE (TRACE_DISK_READ, (c - channels) * 2 + d->dev_no, sec_no, 0);
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_READ_SECTOR_RETRY);
@@ -239,6 +258,7 @@ disk_write (struct disk *d, disk_sector_t sec_no, const void *buffer) {
 	ASSERT (buffer != NULL);
 
 	c = d->channel;
+	TRACE (TRACE_DISK_WRITE, (c - channels) * 2 + d->dev_no, sec_no, 0);
 	lock_acquire (&c->lock);
 	select_sector (d, sec_no);
 	issue_pio_command (c, CMD_WRITE_SECTOR_RETRY);
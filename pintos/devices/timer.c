@@ -5,8 +5,10 @@
 #include <stdio.h>
 #include "threads/interrupt.h"
 #include "threads/io.h"
+#include "threads/profile.h"
 #include "threads/synch.h"
 #include "threads/thread.h"
+#include "intrinsic.h"
 
 /* See [8254] for hardware details of the 8254 timer chip. */
 
@@ -24,19 +26,67 @@ static int64_t ticks;
    Initialized by timer_calibrate(). */
 static unsigned loops_per_tick;
 
+/* Time stamp counter rate in Hz, and its value at calibration.
+   Initialized by timer_calibrate(); until then timer_ns() only
+   has tick resolution. */
+static uint64_t tsc_hz;
+static uint64_t tsc_base;
+static int64_t tsc_base_ticks;
+
+/* Ticks to measure the TSC over in timer_calibrate(). */
+#define TSC_CALIBRATE_TICKS 10
+
+/* -tickless: skip periodic ticks while the CPU is idle.
+
+   When the idle thread is about to halt, timer_idle_enter()
+   reprograms the PIT so that its next interrupt lands on the
+   tick boundary of the earliest pending timeout (at most
+   PIT_MAX_COUNT input clocks away, about 5 ticks at 100 Hz).
+   The interrupt handler then credits all the ticks that cycle
+   covered, one thread_tick() per tick so that scheduler
+   accounting is unchanged, and goes back to the periodic rate.
+   If some other interrupt ends the idle period early,
+   timer_idle_exit() shortens the cycle to the next tick
+   boundary, both when the idle thread wakes and when schedule()
+   switches away from it to a thread that interrupt unblocked.
+   Until the next timer interrupt arrives timer_ticks() can lag
+   by the ticks skipped so far. */
+bool timer_tickless;
+
+#define PIT_MAX_COUNT 65535     /* Largest 16-bit PIT reload value. */
+
+/* PIT input clocks per timer tick. */
+static uint16_t pit_count;
+
+/* Ticks covered by the PIT cycle now running (1 when periodic). */
+static int pit_cycle_ticks = 1;
+
+/* True if the running cycle is not periodic and the next timer
+   interrupt must restore PIT_COUNT. */
+static bool pit_reload;
+
+/* Timer interrupts actually taken (differs from ticks only in
+   tickless mode). */
+static int64_t timer_irqs;
+
 /* ----- Alarm Clock additions ----- */
-static struct list sleep_list; /* 블록된(잠자는) 스레드들의 정렬 리스트 */
+/* 대기 중인 timeout들의 min-heap (가장 이른 만료가 top) */
+static struct heap timeouts;
 
 static intr_handler_func timer_interrupt;
 static bool too_many_loops (unsigned loops);
 static void busy_wait (int64_t loops);
 static void real_time_sleep (int64_t num, int32_t denom);
+static void tsc_calibrate (void);
+static void pit_program (unsigned count);
+static unsigned pit_read (void);
+static bool pit_irq_pending (void);
 
 /* ----- Alarm Clock additions ----- */
-static bool wakeup_less (const struct list_elem *a,
-			 			 const struct list_elem *b,
-			 			 void *aux);
-static void wake_ready_threads_by_timer (void);
+static bool timeout_less (const struct heap_elem *a,
+		const struct heap_elem *b, void *aux);
+static void run_expired_timeouts (void);
+static void wake_sleeper (void *t_);
 
 /* Sets up the 8254 Programmable Interval Timer (PIT) to
    interrupt PIT_FREQ times per second, and registers the
@@ -45,16 +95,13 @@ void
 timer_init (void) {
 	/* 8254 input frequency divided by TIMER_FREQ, rounded to
 	   nearest. */
-	uint16_t count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
-
-	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
-	outb (0x40, count & 0xff);
-	outb (0x40, count >> 8);
+	pit_count = (1193180 + TIMER_FREQ / 2) / TIMER_FREQ;
+	pit_program (pit_count);
 
 	intr_register_ext (0x20, timer_interrupt, "8254 Timer");
 
 	/* ----- Alarm Clock additions ----- */
-	list_init(&sleep_list);
+	heap_init (&timeouts, timeout_less, NULL);
 }
 
 /* Calibrates loops_per_tick, used to implement brief delays. */
@@ -79,7 +126,29 @@ timer_calibrate (void) {
 		if (!too_many_loops (high_bit | test_bit))
 			loops_per_tick |= test_bit;
 
-	printf ("%'"PRIu64" loops/s.\n", (uint64_t) loops_per_tick * TIMER_FREQ);
+	tsc_calibrate ();
+	printf ("%'"PRIu64" loops/s, %'"PRIu64" kHz TSC.\n",
+			(uint64_t) loops_per_tick * TIMER_FREQ, tsc_hz / 1000);
+}
+
+/* Measures the TSC rate against TSC_CALIBRATE_TICKS timer ticks,
+   starting and ending on a tick boundary. */
+static void
+tsc_calibrate (void) {
+	int64_t start;
+	uint64_t tsc0;
+
+	start = ticks;
+	while (ticks == start)
+		barrier ();
+	start = ticks;
+	tsc0 = rdtsc ();
+	while (ticks - start < TSC_CALIBRATE_TICKS)
+		barrier ();
+
+	tsc_base = rdtsc ();
+	tsc_base_ticks = ticks;
+	tsc_hz = (tsc_base - tsc0) / TSC_CALIBRATE_TICKS * TIMER_FREQ;
 }
 
 /* Returns the number of timer ticks since the OS booted. */
@@ -99,6 +168,20 @@ timer_elapsed (int64_t then) {
 	return timer_ticks () - then;
 }
 
+/* Returns nanoseconds since boot from a monotonic clock with
+   TSC resolution once timer_calibrate() has run. */
+int64_t
+timer_ns (void) {
+	if (tsc_hz == 0)
+		return timer_ticks () * (1000000000 / TIMER_FREQ);
+
+	/* 곱셈 오버플로를 피하려고 초 단위 몫과 나머지로 나눠 환산 */
+	uint64_t delta = rdtsc () - tsc_base;
+	uint64_t ns = delta / tsc_hz * 1000000000
+		+ delta % tsc_hz * 1000000000 / tsc_hz;
+	return tsc_base_ticks * (1000000000 / TIMER_FREQ) + (int64_t) ns;
+}
+
 /* Suspends execution for approximately TICKS timer ticks. */
 /* busy-wait 금지 */
 void
@@ -106,16 +189,14 @@ timer_sleep (int64_t ticks) {
 	/* 음수/0 처리: 바로 반환 */
 	if (ticks <= 0) return;
 
-	/* 절대 깨울 시간 계산 */
-	int64_t wake_at = timer_ticks () + ticks;
+	/* 스레드가 블록된 동안 스택은 살아있으므로 timeout을 스택에 둔다 */
+	struct timeout wakeup;
+	timeout_init (&wakeup, wake_sleeper, thread_current ());
 
 	enum intr_level old_level = intr_disable (); /* 크리티컬 섹션 시작 */
 
-	struct thread *cur = thread_current();
-	cur->wakeup_tick = wake_at;
-
-	/* wakeup_tick 오름차순 유지되도록 정렬 삽입 */
-	list_insert_ordered(&sleep_list, &cur->elem, wakeup_less, NULL);
+	/* heap 삽입: O(1) */
+	timeout_add (&wakeup, ticks);
 
 	/* 현재 스레드를 블록: 이후 타이머 인터럽트에서 언블록됨 
 	   상태 전이: RUNNING -> BLOCKED. 
@@ -150,18 +231,138 @@ timer_nsleep (int64_t ns) {
 /* Prints timer statistics. */
 void
 timer_print_stats (void) {
-	printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+	if (timer_tickless)
+		printf ("Timer: %"PRId64" ticks, %"PRId64" interrupts\n",
+				timer_ticks (), timer_irqs);
+	else
+		printf ("Timer: %"PRId64" ticks\n", timer_ticks ());
+}
+
+/* Called by the idle thread, with interrupts off, just before it
+   halts.  In tickless mode, stretches the current PIT cycle so
+   the next interrupt comes at the earliest pending timeout. */
+void
+timer_idle_enter (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	/* 이미 변형된 주기가 돌고 있거나, 틱 경계를 넘어 인터럽트가 대기 중이면 그대로 둠 */
+	if (!timer_tickless || pit_reload || pit_irq_pending ())
+		return;
+
+	int64_t skip = PIT_MAX_COUNT / pit_count;
+	if (!heap_empty (&timeouts)) {
+		struct timeout *first = heap_entry (heap_top (&timeouts),
+				struct timeout, elem);
+		if (first->expires - ticks < skip)
+			skip = first->expires - ticks;
+	}
+	if (skip <= 1)
+		return;
+
+	/* 현재 틱의 남은 카운트를 유지해 위상이 어긋나지 않게 함 */
+	unsigned remain = pit_read ();
+	if (remain == 0 || remain > pit_count)
+		remain = pit_count;
+
+	pit_program (remain + (skip - 1) * pit_count);
+	pit_cycle_ticks = skip;
+	pit_reload = true;
+}
+
+/* Called with interrupts off when the idle thread wakes up or
+   is switched away from.  If a stretched cycle is still running
+   (some other interrupt ended the idle period), cut it short at
+   the next tick boundary and let that interrupt account for the
+   ticks that have passed. */
+void
+timer_idle_exit (void) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!pit_reload || pit_irq_pending ())
+		return;
+
+	/* 남은 카운트로 지나간 틱 수와 다음 틱 경계까지의 카운트를 계산 */
+	unsigned remain = pit_read ();
+	if (remain == 0)
+		return;
+	int left_ticks = DIV_ROUND_UP (remain, pit_count);
+	if (left_ticks > pit_cycle_ticks)
+		return;
+
+	unsigned left = (remain - 1) % pit_count + 1;
+	pit_program (left > 1 ? left : 2);
+	pit_cycle_ticks = pit_cycle_ticks - left_ticks + 1;
 }
 
+/* Initializes timeout T to call FUNC(AUX) when it fires. */
+void
+timeout_init (struct timeout *t, timeout_func *func, void *aux) {
+	ASSERT (t != NULL);
+	ASSERT (func != NULL);
+
+	t->expires = 0;
+	t->func = func;
+	t->aux = aux;
+	t->pending = false;
+}
+
+/* Arms T to fire DELAY timer ticks from now (at least one tick).
+   T must not already be pending.  May be called from an
+   interrupt handler. */
+void
+timeout_add (struct timeout *t, int64_t delay) {
+	ASSERT (t != NULL);
+	ASSERT (!t->pending);
+
+	enum intr_level old_level = intr_disable ();
+	t->expires = ticks + (delay > 0 ? delay : 1);
+	t->pending = true;
+	heap_insert (&timeouts, &t->elem);
+	intr_set_level (old_level);
+}
+
+/* Disarms T.  Returns true if T was pending, false if it had
+   already fired or was never armed. */
+bool
+timeout_cancel (struct timeout *t) {
+	ASSERT (t != NULL);
+
+	enum intr_level old_level = intr_disable ();
+	bool was_pending = t->pending;
+
+	if (was_pending) {
+		heap_remove (&timeouts, &t->elem);
+		t->pending = false;
+	}
+
+	intr_set_level (old_level);
+	return was_pending;
+}
+
 /* Timer interrupt handler.
-   매 틱마다 깨울 스레드가 있는지 즉시 처리.
+   매 틱마다 만료된 timeout(잠자는 스레드 포함)을 즉시 처리.
 */
 static void
-timer_interrupt (struct intr_frame *args UNUSED) {
-	ticks++;
-	thread_tick ();
+timer_interrupt (struct intr_frame *args) {
+	int n = pit_cycle_ticks;
+
+	timer_irqs++;
+	if (profile_enabled)
+		profile_sample (args);
+	if (pit_reload) {
+		/* tickless로 늘렸던 주기를 원래 주기로 복구 */
+		pit_program (pit_count);
+		pit_cycle_ticks = 1;
+		pit_reload = false;
+	}
 
-	wake_ready_threads_by_timer ();
+	/* 건너뛴 틱도 하나씩 계산해 스케줄러 통계/MLFQS 경계가 그대로 유지되게 함 */
+	while (n-- > 0) {
+		ticks++;
+		thread_tick ();
+	}
+
+	run_expired_timeouts ();
 }
 
 /* Returns true if LOOPS iterations waits for more than one timer
@@ -217,56 +418,80 @@ real_time_sleep (int64_t num, int32_t denom) {
 		   sub-tick timing.  We scale the numerator and denominator
 		   down by 1000 to avoid the possibility of overflow. */
 		ASSERT (denom % 1000 == 0);
-		busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
+		if (tsc_hz != 0) {
+			/* 보정된 TSC가 있으면 루프 수 추정 대신 마감 시각까지 돈다 */
+			int64_t deadline = timer_ns () + num * (1000000000 / denom);
+			while (timer_ns () < deadline)
+				barrier ();
+		} else
+			busy_wait (loops_per_tick * num / 1000 * TIMER_FREQ / (denom / 1000));
 	}
 }
 
-/* 정렬 비교 함수: wakeup_tick 오름차순, 동률이면 FIFO(뒤에 삽입) 또는 우선순위 */
-static bool 
-wakeup_less (const struct list_elem *a,
-			 const struct list_elem *b,
-			 void *aux) 
-{
-	const struct thread *ta = list_entry(a, struct thread, elem);
-	const struct thread *tb = list_entry(b, struct thread, elem);
-
-	if (ta->wakeup_tick != tb->wakeup_tick) {
-		return ta->wakeup_tick < tb->wakeup_tick; // 오름차순
-	}
+/* Restarts PIT counter 0 in rate-generator mode with COUNT input
+   clocks per interrupt. */
+static void
+pit_program (unsigned count) {
+	ASSERT (count > 1 && count <= PIT_MAX_COUNT);
 
-	/* 동률이면 우선순위 큰 스레드를 앞에 */
-	return ta->priority > tb->priority;
+	outb (0x43, 0x34);    /* CW: counter 0, LSB then MSB, mode 2, binary. */
+	outb (0x40, count & 0xff);
+	outb (0x40, count >> 8);
 }
 
-/* wakeup loop */
-static void
-wake_ready_threads_by_timer (void)
-{
-	/* 핸들러 문맥: 이미 인터럽트 비활성화 상태.
-	   더 높은 우선순위 스레드를 깨웠는지 추적.
-	*/
-	bool need_yield = false;
+/* Returns the input clocks left before counter 0's next
+   interrupt. */
+static unsigned
+pit_read (void) {
+	uint8_t lo, hi;
 
-	while (!list_empty(&sleep_list)) {
-		/* 정렬 리스트의 맨 앞이 가장 이른 wakeup_tick */
-		struct thread *t = list_entry (list_front (&sleep_list), struct thread, elem);
+	outb (0x43, 0x00);    /* Latch counter 0. */
+	lo = inb (0x40);
+	hi = inb (0x40);
+	return lo | (hi << 8);
+}
 
-		/* 지금 깨울 차례가 아니면 종료 (정렬 리스트이므로 맨 앞만 보면 됨) */
-		if (t->wakeup_tick > timer_ticks ()) {
-			break;
-		}
+/* Returns true if the PIC has a timer interrupt latched but not
+   yet delivered. */
+static bool
+pit_irq_pending (void) {
+	outb (0x20, 0x0a);    /* OCW3: read IRR. */
+	return inb (0x20) & 0x01;
+}
 
-		/* 깨울 시각이 지났다면 리스트에서 빼고 ready로 전환 */
-		list_pop_front (&sleep_list);
-		thread_unblock (t);
+/* Orders timeouts by expiry, earliest first. */
+static bool
+timeout_less (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct timeout, elem)->expires
+		< heap_entry (b, struct timeout, elem)->expires;
+}
 
-		/* 우선순위 스케줄링 대비: 더 높은 우선순위를 깨웠다면 반환 직후 양보 */
-		if (t->priority > thread_current()->priority) {
-			need_yield = true;
-		}
-	}
+/* Fires every timeout whose expiry has been reached.  Runs in
+   the timer interrupt handler, so interrupts are already off. */
+static void
+run_expired_timeouts (void) {
+	/* top이 가장 이른 만료 시각이므로 top만 보면 됨 */
+	while (!heap_empty (&timeouts)) {
+		struct timeout *t = heap_entry (heap_top (&timeouts),
+				struct timeout, elem);
+		if (t->expires > ticks)
+			break;
 
-	if (need_yield) {
-		intr_yield_on_return (); /* 핸들러 '리턴 후' 양보 (인터럽트 안에서 yield 금지 -> 문맥상 불가) */
+		heap_pop (&timeouts);
+		t->pending = false;
+		t->func (t->aux);
 	}
-}
\ No newline at end of file
+}
+
+/* timer_sleep()의 timeout 콜백: 잠든 스레드를 ready로 전환 */
+static void
+wake_sleeper (void *t_) {
+	struct thread *t = t_;
+
+	thread_unblock (t);
+
+	/* 우선순위 스케줄링 대비: 더 높은 우선순위를 깨웠다면 핸들러 '리턴 후' 양보 */
+	if (t->priority > thread_current ()->priority)
+		intr_yield_on_return ();
+}
@@ -15,7 +15,7 @@ struct disk *filesys_disk;
 
 static void do_format (void);
 
-struct lock fs_lock;		// 전역 파일시스템 락 정의(단 한 곳)
+struct rwlock fs_lock;		// 전역 파일시스템 락 정의(단 한 곳)
 
 /* Initializes the file system module.
  * If FORMAT is true, reformats the file system. */
@@ -44,7 +44,8 @@ filesys_init (bool format) {
 	free_map_open ();
 #endif
 
-	lock_init(&fs_lock);
+	rwlock_init (&fs_lock);
+	lock_set_name (&fs_lock.writer, "fs_lock");	/* 쓰기 + 느린 경로 읽기만 집계 */
 }
 
 /* Shuts down the file system module, writing any unwritten data
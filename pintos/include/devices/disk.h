@@ -18,6 +18,9 @@ typedef uint32_t disk_sector_t;
 void disk_init (void);
 void disk_print_stats (void);
 
+struct sys_stats;
+void disk_get_stats (struct sys_stats *);
+
 struct disk *disk_get (int chan_no, int dev_no);
 disk_sector_t disk_size (struct disk *);
 void disk_read (struct disk *, disk_sector_t, void *);
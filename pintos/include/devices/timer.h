@@ -1,7 +1,9 @@
 #ifndef DEVICES_TIMER_H
 #define DEVICES_TIMER_H
 
+#include <heap.h>
 #include <round.h>
+#include <stdbool.h>
 #include <stdint.h>
 
 /* Number of timer interrupts per second. */
@@ -12,6 +14,7 @@ void timer_calibrate (void);
 
 int64_t timer_ticks (void);
 int64_t timer_elapsed (int64_t);
+int64_t timer_ns (void);
 
 void timer_sleep (int64_t ticks);
 void timer_msleep (int64_t milliseconds);
@@ -20,4 +23,32 @@ void timer_nsleep (int64_t nanoseconds);
 
 void timer_print_stats (void);
 
+/* Dynamic ticks (-tickless). */
+extern bool timer_tickless;
+void timer_idle_enter (void);
+void timer_idle_exit (void);
+
+/* Kernel timeouts.
+
+   A timeout calls FUNC(AUX) from the timer interrupt handler,
+   with interrupts off, once the tick count reaches EXPIRES.
+   Pending timeouts are kept in a pairing heap (lib/kernel/heap.h)
+   ordered by expiry, so arming is O(1), finding the earliest is
+   O(1) and expiring or cancelling one is O(log n) amortized,
+   with no memory allocation.  The struct
+   must stay valid until it fires or is cancelled. */
+typedef void timeout_func (void *aux);
+
+struct timeout {
+	int64_t expires;                /* Absolute tick to fire at. */
+	timeout_func *func;             /* Callback. */
+	void *aux;                      /* Argument to FUNC. */
+	bool pending;                   /* Armed and not yet fired? */
+	struct heap_elem elem;          /* Pending-timeout heap element. */
+};
+
+void timeout_init (struct timeout *, timeout_func *, void *aux);
+void timeout_add (struct timeout *, int64_t delay);
+bool timeout_cancel (struct timeout *);
+
 #endif /* devices/timer.h */
@@ -43,6 +43,13 @@ static __inline uint64_t read_eflags(void) {
 	return rflags;
 }
 
+__attribute__((always_inline))
+static __inline uint64_t rdtsc(void) {
+	uint32_t lo, hi;
+	__asm __volatile("rdtsc" : "=a" (lo), "=d" (hi));
+	return ((uint64_t) hi << 32) | lo;
+}
+
 __attribute__((always_inline))
 static __inline uint64_t rcr3(void) {
 	uint64_t val;
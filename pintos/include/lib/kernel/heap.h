@@ -0,0 +1,62 @@
+#ifndef __LIB_KERNEL_HEAP_H
+#define __LIB_KERNEL_HEAP_H
+
+/* Priority queue (pairing heap).
+ *
+ * Like list.h and hash.h, the heap does not use dynamic
+ * allocation: each structure that can be in a heap embeds a
+ * struct heap_elem, and heap_entry() converts a heap_elem back
+ * to the structure that contains it.  That makes it usable with
+ * interrupts disabled and from interrupt handlers.
+ *
+ * The element at the top is one for which no other element is
+ * "less" according to the heap's LESS function, so passing a
+ * "greater than" function gives a max-heap.  heap_insert() and
+ * heap_top() are O(1); heap_pop() and heap_remove() are
+ * O(log n) amortized.
+ *
+ * An element's key must not change while it is in a heap.  To
+ * re-key an element, heap_remove() it, change the key, then
+ * heap_insert() it again. */
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Heap element. */
+struct heap_elem {
+	struct heap_elem *child;    /* Leftmost child. */
+	struct heap_elem *sibling;  /* Next sibling to the right. */
+	struct heap_elem *prev;     /* Left sibling, or parent if leftmost. */
+};
+
+/* Converts pointer to heap element HEAP_ELEM into a pointer to
+ * the structure that HEAP_ELEM is embedded inside. */
+#define heap_entry(HEAP_ELEM, STRUCT, MEMBER)           \
+	((STRUCT *) ((uint8_t *) &(HEAP_ELEM)->child    \
+		- offsetof (STRUCT, MEMBER.child)))
+
+/* Compares the value of two heap elements A and B, given
+ * auxiliary data AUX.  Returns true if A should be nearer the
+ * top than B. */
+typedef bool heap_less_func (const struct heap_elem *a,
+		const struct heap_elem *b,
+		void *aux);
+
+/* Heap. */
+struct heap {
+	struct heap_elem *root;     /* Top element, or null if empty. */
+	size_t elem_cnt;            /* Number of elements in heap. */
+	heap_less_func *less;       /* Comparison function. */
+	void *aux;                  /* Auxiliary data for `less'. */
+};
+
+void heap_init (struct heap *, heap_less_func *, void *aux);
+void heap_insert (struct heap *, struct heap_elem *);
+struct heap_elem *heap_top (const struct heap *);
+struct heap_elem *heap_pop (struct heap *);
+void heap_remove (struct heap *, struct heap_elem *);
+size_t heap_size (const struct heap *);
+bool heap_empty (const struct heap *);
+
+#endif /* lib/kernel/heap.h */
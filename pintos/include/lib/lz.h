@@ -0,0 +1,29 @@
+#ifndef __LIB_LZ_H
+#define __LIB_LZ_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Fast LZ77 block compression in the style of LZ4.
+ *
+ * Meant for small blocks such as single pages: inputs must be
+ * at most LZ_MAX_INPUT bytes.  There is no framing, so the
+ * caller has to remember both the compressed and the original
+ * size. */
+
+#define LZ_MAX_INPUT 65535
+#define LZ_HASH_BITS 12
+
+/* Scratch space for lz_compress().  Large enough that callers
+ * should not put it on a kernel thread's stack. */
+struct lz_work {
+	uint16_t table[1 << LZ_HASH_BITS];  /* Recent position + 1, per hash. */
+};
+
+size_t lz_compress (const void *src, size_t src_size,
+		void *dst, size_t dst_size, struct lz_work *);
+bool lz_decompress (const void *src, size_t src_size,
+		void *dst, size_t dst_size);
+
+#endif /* lib/lz.h */
@@ -0,0 +1,69 @@
+#ifndef __LIB_STATS_H
+#define __LIB_STATS_H
+
+#include <stdint.h>
+
+/* Statistics records shared by the kernel and user programs.
+   The kernel copies these out through system calls, so their
+   layout is part of the system call interface. */
+
+/* Per-process virtual memory statistics, returned by vmstat(). */
+struct vm_stats {
+	uint64_t minor_faults;      /* Faults served without disk I/O. */
+	uint64_t major_faults;      /* Faults that read swap or a file. */
+	uint64_t stack_faults;      /* Faults that grew the stack. */
+	uint64_t evictions;         /* Pages evicted from this process. */
+	uint64_t swap_ins;          /* Pages read back from swap. */
+	uint64_t swap_outs;         /* Pages written to swap. */
+	uint64_t resident_pages;    /* Pages currently in frames. */
+	uint64_t peak_resident;     /* Largest RESIDENT_PAGES seen. */
+	uint64_t readahead_pages;   /* Swap slots prefetched by our faults. */
+	uint64_t swap_cache_hits;   /* Swap-ins served from the swap cache. */
+	uint64_t zswap_hits;        /* Swap-ins served from the compressed pool. */
+	uint64_t fault_around_pages; /* Pages mapped ahead of file faults. */
+};
+
+/* System-wide counters, returned by sysstat().
+
+   Fields are only ever appended, and each addition bumps
+   SYS_STATS_VERSION.  The kernel fills in at most as many bytes
+   as the caller's struct has, so programs built against an
+   older layout keep working; VERSION and SIZE tell a program
+   what the kernel actually filled in. */
+#define SYS_STATS_VERSION 2
+
+/* Disks are indexed by channel * 2 + device, so hd0:0 is 0 and
+   the swap disk hd1:1 is 3. */
+#define SYS_STATS_DISKS 4
+
+struct sys_stats {
+	uint32_t version;           /* SYS_STATS_VERSION of the kernel. */
+	uint32_t size;              /* Bytes filled in. */
+
+	/* Timer. */
+	uint64_t ticks;             /* Timer ticks since boot. */
+	uint64_t idle_ticks;        /* Ticks spent in the idle thread. */
+	uint64_t kernel_ticks;      /* Ticks spent in kernel threads. */
+	uint64_t user_ticks;        /* Ticks spent in user processes. */
+
+	/* Scheduler. */
+	uint64_t context_switches;  /* Switches to a different thread. */
+
+	/* Disks. */
+	uint64_t disk_reads[SYS_STATS_DISKS];   /* Sectors read. */
+	uint64_t disk_writes[SYS_STATS_DISKS];  /* Sectors written. */
+
+	/* Virtual memory. */
+	uint64_t page_faults;       /* Page faults taken. */
+	uint64_t evictions;         /* Frames evicted. */
+	uint64_t free_frames;       /* User frames not holding a page. */
+	uint64_t swap_slots_used;   /* Swap slots holding a page. */
+	uint64_t swap_slots;        /* Total swap slots. */
+
+	/* Compressed swap pool (version 2). */
+	uint64_t zswap_stored;      /* Pages held compressed in memory. */
+	uint64_t zswap_pool_pages;  /* Kernel pages backing the pool. */
+	uint64_t zswap_writebacks;  /* Pages moved to disk to make room. */
+};
+
+#endif /* lib/stats.h */
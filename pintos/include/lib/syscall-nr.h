@@ -36,6 +36,11 @@ enum {
 
 	SYS_MOUNT,
 	SYS_UMOUNT,
+
+	/* Statistics. */
+	SYS_VMSTAT,                 /* Obtain this process's VM statistics. */
+	SYS_SYSSTAT,                /* Obtain system-wide statistics. */
+	SYS_CLOCK,                  /* Read the monotonic nanosecond clock. */
 };
 
 #endif /* lib/syscall-nr.h */
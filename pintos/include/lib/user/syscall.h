@@ -4,6 +4,7 @@
 #include <stdbool.h>
 #include <debug.h>
 #include <stddef.h>
+#include <stats.h>
 
 /* Process identifier. */
 typedef int pid_t;
@@ -50,6 +51,11 @@ bool isdir (int fd);
 int inumber (int fd);
 int symlink (const char* target, const char* linkpath);
 
+/* Statistics. */
+bool vmstat (struct vm_stats *);
+bool sysstat (struct sys_stats *);
+int64_t clock_ns (void);
+
 static inline void* get_phys_addr (void *user_addr) {
 	void* pa;
 	asm volatile ("movq %0, %%rax" ::"r"(user_addr));
@@ -0,0 +1,77 @@
+#ifndef THREADS_FIXED_POINT_H
+#define THREADS_FIXED_POINT_H
+
+#include <stdint.h>
+
+/* 17.14 fixed-point real numbers for the MLFQS scheduler.
+ *
+ * The kernel cannot use floating point, so recent_cpu and
+ * load_avg are kept as signed integers whose low FP_SHIFT bits
+ * are the fraction: 17 integer bits, 14 fractional bits and a
+ * sign bit.  x and y below are fixed-point, n is an integer.
+ * Products and quotients of two fixed-point values go through
+ * int64_t so the intermediate result cannot overflow. */
+typedef int fixed_t;
+
+#define FP_SHIFT 14
+#define FP_F (1 << FP_SHIFT)            /* 1.0 in fixed point. */
+
+/* n -> fixed. */
+static inline fixed_t
+fp_from_int (int n) {
+	return n * FP_F;
+}
+
+/* fixed -> int, rounding toward zero. */
+static inline int
+fp_to_int (fixed_t x) {
+	return x / FP_F;
+}
+
+/* fixed -> int, rounding to nearest. */
+static inline int
+fp_to_int_round (fixed_t x) {
+	return x >= 0 ? (x + FP_F / 2) / FP_F : (x - FP_F / 2) / FP_F;
+}
+
+static inline fixed_t
+fp_add (fixed_t x, fixed_t y) {
+	return x + y;
+}
+
+static inline fixed_t
+fp_sub (fixed_t x, fixed_t y) {
+	return x - y;
+}
+
+static inline fixed_t
+fp_add_int (fixed_t x, int n) {
+	return x + n * FP_F;
+}
+
+static inline fixed_t
+fp_sub_int (fixed_t x, int n) {
+	return x - n * FP_F;
+}
+
+static inline fixed_t
+fp_mul (fixed_t x, fixed_t y) {
+	return (fixed_t) (((int64_t) x) * y / FP_F);
+}
+
+static inline fixed_t
+fp_mul_int (fixed_t x, int n) {
+	return x * n;
+}
+
+static inline fixed_t
+fp_div (fixed_t x, fixed_t y) {
+	return (fixed_t) (((int64_t) x) * FP_F / y);
+}
+
+static inline fixed_t
+fp_div_int (fixed_t x, int n) {
+	return x / n;
+}
+
+#endif /* threads/fixed-point.h */
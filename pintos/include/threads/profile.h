@@ -0,0 +1,15 @@
+#ifndef THREADS_PROFILE_H
+#define THREADS_PROFILE_H
+
+#include <stdbool.h>
+
+struct intr_frame;
+
+/* -profile: sample the interrupted RIP on every timer interrupt. */
+extern bool profile_enabled;
+
+void profile_init (void);
+void profile_sample (const struct intr_frame *);
+void profile_print (void);
+
+#endif /* threads/profile.h */
@@ -1,8 +1,10 @@
 #ifndef THREADS_SYNCH_H
 #define THREADS_SYNCH_H
 
+#include <heap.h>
 #include <list.h>
 #include <stdbool.h>
+#include <stdint.h>
 
 /* A counting semaphore. */
 struct semaphore {
@@ -20,6 +22,16 @@ void sema_self_test (void);
 struct lock {
 	struct thread *holder;      /* Thread holding lock (for debugging). */
 	struct semaphore semaphore; /* Binary semaphore controlling access. */
+
+	/* ----- Priority donation ----- */
+	struct heap donors;         /* 이 lock을 기다리는 스레드들 (priority max-heap). */
+	struct heap_elem held_elem; /* holder->held_locks의 원소. */
+	int donation;               /* 이 lock을 통한 기부값 (최고 대기자 priority). */
+
+#ifdef LOCKSTAT
+	struct lockstat *stat;      /* Contention counters, null if unnamed. */
+	int64_t acquired_at;        /* Tick at which HOLDER got the lock. */
+#endif
 };
 
 void lock_init (struct lock *);
@@ -28,10 +40,44 @@ bool lock_try_acquire (struct lock *);
 void lock_release (struct lock *);
 bool lock_held_by_current_thread (const struct lock *);
 
+/* Lock contention statistics.
+
+   Compiled in with `make LOCKSTAT=1' and switched on at boot with
+   -lockstat.  Named locks are tracked per name, so all locks
+   given the same name (say, every malloc descriptor's) are added
+   together.  Without LOCKSTAT the hooks compile away entirely. */
+#ifdef LOCKSTAT
+extern bool lockstat_enabled;
+void lock_set_name (struct lock *, const char *name);
+void lockstat_print (void);
+#else
+#define lock_set_name(LOCK, NAME) ((void) 0)
+#endif
+
+/* Reader-writer lock.
+
+   Any number of readers, or one writer.  Writer-preferring: once
+   a writer is waiting, new readers queue behind it.  The writer
+   holds WRITER for its whole critical section, so threads blocked
+   behind it donate priority to it as with any lock. */
+struct rwlock {
+	struct lock writer;         /* Held by the active or draining writer. */
+	struct semaphore drained;   /* Upped by the last reader for the writer. */
+	unsigned readers;           /* Number of active readers. */
+	bool writer_waiting;        /* Writer is waiting for readers to leave? */
+};
+
+void rwlock_init (struct rwlock *);
+void rwlock_acquire_read (struct rwlock *);
+void rwlock_release_read (struct rwlock *);
+void rwlock_acquire_write (struct rwlock *);
+void rwlock_release_write (struct rwlock *);
+bool rwlock_held_for_write (const struct rwlock *);
+
 /* Condition variable. */
 struct condition {
-	/* 스레드가 아니라 semaphore_elem 임. */
-	struct list waiters;        /* List of waiting threads. */
+	/* 스레드가 아니라 semaphore_elem 임. (priority max-heap) */
+	struct heap waiters;        /* Heap of waiting threads. */
 };
 
 void cond_init (struct condition *);
@@ -39,6 +85,9 @@ void cond_wait (struct condition *, struct lock *);
 void cond_signal (struct condition *, struct lock *);
 void cond_broadcast (struct condition *, struct lock *);
 
+struct thread;
+void cond_resort_waiter (struct thread *);
+
 /* Optimization barrier.
  *
  * The compiler will not reorder operations across an
@@ -2,8 +2,10 @@
 #define THREADS_THREAD_H
 
 #include <debug.h>
+#include <heap.h>
 #include <list.h>
 #include <stdint.h>
+#include "threads/fixed-point.h"
 #include "threads/interrupt.h"
 #ifdef VM
 #include "vm/vm.h"
@@ -32,6 +34,11 @@ typedef int tid_t;
 #define PRI_DEFAULT 31                  /* Default priority. */
 #define PRI_MAX 63                      /* Highest priority. */
 
+/* Thread niceness (MLFQS). */
+#define NICE_MIN -20                    /* Nicest to other threads. */
+#define NICE_DEFAULT 0                  /* Default niceness. */
+#define NICE_MAX 20                     /* Least nice. */
+
 /* A kernel thread or user process.
  *
  * Each thread structure is stored in its own 4 kB page.  The
@@ -99,6 +106,7 @@ struct thread {
 
 	/* Shared between thread.c and synch.c. */
 	struct list_elem elem;              /* List element. */
+	int ready_priority;                 /* READY일 때 들어가 있는 run queue 번호. */
 
 #ifdef USERPROG
 	/* Owned by userprog/process.c. */
@@ -130,21 +138,27 @@ struct thread {
 	/* Owned by thread.c. */
 	struct intr_frame tf;               /* Information for switching */
 
-	/* ----- Alarm Clock additions ----- */
-	int64_t wakeup_tick; /* 이 스레드를 깨워야 할 절대 tick (timer_ticks() 기준) */
-
 	/* 원래 우선순위(사용자 설정값) */
 	int base_priority; 
 
-	/* 나에게 우선순위를 기부한 스레드들의 리스트 */
-	struct list donations; /* elements: donor->donation_elem */
+	/* 내가 보유한 lock들의 max-heap (키: lock->donation).
+	   top이 나에게 들어온 기부 중 최댓값 */
+	struct heap held_locks; /* elements: lock->held_elem */
 
-	/* 내가 남에게 기부자로 들어갈 때 사용할 리스트 노드 (단일 용도) */
-	struct list_elem donation_elem;
+	/* wait_on_lock->donors에 기부자로 들어갈 때 쓰는 노드 (키: priority) */
+	struct heap_elem donor_elem;
 
 	/* 지금 대기 중인 락 (없으면 NULL). 중첩 기부 전파용 */
 	struct lock *wait_on_lock;
 
+	/* cond_wait() 중이면 그 대기자 (없으면 NULL). 우선순위 변동 시 재정렬용 */
+	struct semaphore_elem *cond_waiter;
+
+	/* ----- MLFQS ----- */
+	int nice;                           /* 다른 스레드에 양보하는 정도 (-20..20) */
+	fixed_t recent_cpu;                 /* 최근 CPU 사용량 (17.14 고정소수점) */
+	struct list_elem all_elem;          /* all_list 연결용 */
+
 	unsigned magic;                     /* Detects stack overflow. */
 };
 
@@ -157,7 +171,9 @@ void thread_init (void);
 void thread_start (void);	
 
 void thread_tick (void);
+struct sys_stats;
 void thread_print_stats (void);
+void thread_get_stats (struct sys_stats *);
 
 typedef void thread_func (void *aux);
 tid_t thread_create (const char *name, int priority, thread_func *, void *);
@@ -187,7 +203,6 @@ bool thread_cmp_priority (const struct list_elem *a,
                      	  void *aux UNUSED);
 
 void thread_refresh_priority(struct thread *t);
-void thread_remove_donations_for_lock(struct thread *t, struct lock *lock);
 void thread_resort_ready_member(struct thread *t);
 
 #endif /* threads/thread.h */
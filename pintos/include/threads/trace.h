@@ -0,0 +1,46 @@
+#ifndef THREADS_TRACE_H
+#define THREADS_TRACE_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* Static tracepoints.
+
+   With -trace, each TRACE() appends a fixed-size binary record
+   (TSC timestamp, event, tid and three arguments) to a ring
+   buffer allocated at boot.  trace_dump() writes the buffer to
+   the console at power off as hex lines, which
+   utils/trace-decode turns back into a readable event log.
+
+   Keep the event numbers in sync with utils/trace-decode. */
+enum trace_event {
+	TRACE_SCHEDULE = 0,         /* prev tid, next tid, prev status. */
+	TRACE_BLOCK = 1,            /* caller's return address. */
+	TRACE_UNBLOCK = 2,          /* unblocked tid, its priority. */
+	TRACE_FAULT = 3,            /* fault addr, write, user. */
+	TRACE_FAULT_DONE = 4,       /* fault addr, handled. */
+	TRACE_EVICT = 5,            /* frame kva, victim va. */
+	TRACE_SWAP_IN = 6,          /* va, swap slot. */
+	TRACE_SWAP_OUT = 7,         /* va, swap slot. */
+	TRACE_DISK_READ = 8,        /* disk (channel * 2 + dev), sector. */
+	TRACE_DISK_WRITE = 9,       /* disk (channel * 2 + dev), sector. */
+	TRACE_SYSCALL = 10,         /* syscall number, arg0, arg1. */
+	TRACE_SYSCALL_DONE = 11,    /* syscall number, return value. */
+};
+
+extern bool trace_enabled;
+
+void trace_init (void);
+void trace_event (enum trace_event, uint64_t, uint64_t, uint64_t);
+void trace_dump (void);
+
+/* Records EVENT with up to three integer or pointer arguments.
+   Costs one flag test when tracing is off. */
+#define TRACE(EVENT, A0, A1, A2)                                        \
+	do {                                                            \
+		if (trace_enabled)                                      \
+			trace_event (EVENT, (uint64_t) (A0),            \
+					(uint64_t) (A1), (uint64_t) (A2));      \
+	} while (0)
+
+#endif /* threads/trace.h */
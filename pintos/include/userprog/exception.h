@@ -9,4 +9,7 @@
 void exception_init (void);
 void exception_print_stats (void);
 
+struct sys_stats;
+void exception_get_stats (struct sys_stats *);
+
 #endif /* userprog/exception.h */
@@ -13,6 +13,7 @@ struct file_page {
 	off_t ofs;			/* 파일 내 이 페이지의 시작 오프셋 */
 	size_t read_bytes;	/* 파일에서 실제로 읽어올 바이트 수 (마지막 페이지는 PGSIZE보다 작을 수 있음) */
 	size_t zero_bytes;	/* 나머지 0으로 채울 바이트 수 = PGSIZE - read_bytes */
+	bool shareable;		/* 실행 파일의 읽기 전용 페이지: 같은 위치를 읽는 프로세스끼리 프레임 공유 */
 };
 
 /* UNINIT 페이지의 init(aux)로 넘겨줄 1회성 정보 패킷 */
@@ -28,7 +29,6 @@ struct file_lazy_aux {
 struct mmap_region {
 	void *start;			/* 매핑 시작 VA (반환값) */
 	size_t page_cnt;		/* 매핑된 페이지 수 */
-	struct file *file;		/* 이 매핑 전용으로 reopen한 파일 핸들 */
 	bool writable;			/* 페이지 쓰기 가능 여부 */
 	struct list_elem elem;	/* thread->mmaps 에 들어갈 리스트 엘리먼트 */
 };
@@ -44,5 +44,5 @@ void do_munmap (void *va);
 #endif
 
 /* file_page는 페이지 단위 메타(어느 파일/어디서/얼마나 읽을지)를 담음.
- * mmap_region은 매핑 덩어리 단위(여러 페이지) 관리용. file_close()는 region 쪽에서 한 번만!
+ * mmap_region은 매핑 덩어리 단위(여러 페이지) 관리용. 파일 핸들은 영역(struct vma)이 하나만 가짐!
  * file_lazy_aux는 UNINIT → 첫 폴트 시 로더에 전달할 1회성 정보. */
\ No newline at end of file
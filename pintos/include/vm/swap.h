@@ -0,0 +1,40 @@
+#ifndef VM_SWAP_H
+#define VM_SWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* 스왑 슬롯 할당기.
+ * 스왑 디스크를 SWAP_CLUSTER 슬롯 단위 클러스터로 나누고, 완전히 빈 클러스터는
+ * 리스트로 관리해 O(1)에 꺼낸다. 각 프로세스(SPT)는 커서를 하나씩 가지고
+ * 자기 클러스터 안에서 앞으로만 슬롯을 잡으므로, 함께 퇴출된 페이지는
+ * 디스크에서도 연속된 슬롯에 놓인다. 빈 클러스터가 없으면 전역 next-fit 커서로 구멍을 찾음. */
+
+#define SWAP_NONE SIZE_MAX		/* 슬롯 없음(할당 실패, 또는 스왑된 적 없음) */
+
+/* -swapra=N: 스왑 폴트 때 뒤따르는 슬롯을 최대 N개까지 미리 읽음(0이면 끔) */
+extern unsigned swap_readahead_max;
+
+/* 프로세스별 할당 커서: 현재 클러스터 안에서 다음에 시도할 슬롯 */
+struct swap_cursor {
+	size_t next;			/* 다음 후보 슬롯 (SWAP_NONE이면 클러스터 없음) */
+	size_t end;				/* 현재 클러스터의 끝(배타) */
+};
+
+void swap_init (void);
+void swap_cursor_init (struct swap_cursor *);
+size_t swap_alloc (struct swap_cursor *);
+void swap_free (size_t slot);
+void swap_read (size_t slot, void *kva);
+void swap_write (size_t slot, const void *kva);
+bool swap_available (void);
+
+/* 스왑 캐시: read-ahead로 미리 읽어둔 슬롯 내용 */
+bool swap_cache_take (size_t slot, void *kva);
+bool swap_cached (size_t slot);
+size_t swap_readahead (size_t slot);
+
+struct sys_stats;
+void swap_get_stats (struct sys_stats *);
+
+#endif /* vm/swap.h */
@@ -1,6 +1,7 @@
 #ifndef VM_VM_H
 #define VM_VM_H
 #include <stdbool.h>
+#include <stats.h>
 #include "threads/palloc.h"
 
 enum vm_type {
@@ -27,12 +28,16 @@ enum vm_type {
 #include "vm/uninit.h"
 #include "vm/anon.h"
 #include "vm/file.h"
+#include "vm/vma.h"
 #ifdef EFILESYS
 #include "filesys/page_cache.h"
 #endif
 
+#include "vm/swap.h"
+#include "vm/zswap.h"
 #include "hash.h"
 #include "threads/mmu.h" /* pml4 */
+#include "threads/synch.h"
 
 struct page_operations;
 struct thread;
@@ -45,6 +50,10 @@ struct page {
 	const struct page_operations *operations;
 	void *va;              /* Address in terms of user space */
 	struct frame *frame;   /* Back reference for frame */
+	struct supplemental_page_table *spt;	/* 이 페이지가 속한 SPT(통계 갱신용) */
+	bool zero_mapped;			// 프레임 없이 공유 제로 페이지에 읽기 전용으로 매핑됨
+	uint64_t *pml4;				// frame에 매핑한 주소 공간 (frame이 있을 때만 유효)
+	struct list_elem rmap_elem;	// frame->rmap 연결
 
 	/* Your implementation */
 	bool writable;				// 이 페이지를 유저가 쓸 수 있는지
@@ -66,10 +75,12 @@ struct page {
 /* "struct frame"은 물리 페이지(커널 가상주소로 맵핑된 한 프레임)를 뜻함. */
 struct frame {
 	void *kva;			// 이 프레임의 커널 가상주소(커널이 이 물리 페이지에 접근할 때 사용)
-	struct page *page;	// 이 프레임을 점유 중인 상응하는 'struct page'(없으면 NULL)
+	struct list rmap;	// 이 프레임을 매핑한 'struct page'들 (역방향 매핑, 보통 1개. 비었으면 빈 프레임)
 
 	struct list_elem elem;	/* frame_table 연결용 */
-	uint64_t *pml4; 		/* 이 프레임을 매핑한 페이지테이블(더 정확한 dirty/accessed 판정용) */
+	struct share *share;	/* 프로세스 간 공유 중인 실행 파일 페이지면 그 항목 */
+	bool pinned;			/* fork가 내용을 복사하는 중: 퇴출 대상에서 제외 (frame_lock) */
+	bool evicting;			/* 퇴출 배치가 frame_lock 없이 쓰는 중 (끝나면 evict_cond) */
 };
 
 /* 각 페이지 타입이 구현해야 하는 인터페이스(연산 테이블).
@@ -91,6 +102,12 @@ struct page_operations {
  * All designs up to you for this. */
 struct supplemental_page_table {
 	struct hash pages; 			// key: upage(va), value: struct page*
+	struct vma_tree vmas;		// 실행 파일 세그먼트/mmap 영역: 페이지는 첫 폴트 때 여기서 만듦
+	struct rwlock lock;			// pages 보호: 조회는 read, 삽입/삭제는 write
+	struct vm_stats stats;		// 이 프로세스의 폴트/스왑/RSS 통계 (vmstat 시스템콜)
+	struct swap_cursor swap_cursor;	// 스왑 아웃 시 연속 슬롯을 잡기 위한 커서
+	void *fa_next;				// 직전 fault-around 창 바로 다음 VA (순차 접근 판별)
+	unsigned fa_window;			// 다음 파일 폴트 때 미리 들일 페이지 수
 };
 
 #include "threads/thread.h"
@@ -102,6 +119,20 @@ struct page *spt_find_page (struct supplemental_page_table *spt,
 		void *va);
 bool spt_insert_page (struct supplemental_page_table *spt, struct page *page);
 void spt_remove_page (struct supplemental_page_table *spt, struct page *page);
+bool spt_range_free (struct supplemental_page_table *spt, void *start, void *end);
+
+/* -vmstat: 프로세스 종료 시 VM 통계 요약 출력 */
+extern bool vmstat_enabled;
+/* -faultaround=N: 파일 폴트 때 이어지는 페이지를 최대 N개까지 함께 매핑(0이면 끔) */
+extern unsigned fault_around_max;
+void vm_print_stats (const struct supplemental_page_table *spt);
+void vm_stat_unresident (struct page *page);
+void vm_get_stats (struct sys_stats *st);
+void vm_release_frame (struct page *page);
+struct frame *vm_pin_frame (struct page *page);
+void vm_unpin_frame (struct frame *frame);
+bool vm_frame_is_dirty (struct frame *frame);
+void vm_frame_clear_dirty (struct frame *frame);
 
 /* VM 서브시스템 전역 초기화(프레임 풀, 스왑, 페이지 캐시 등 하위 시스템 초기화 포함 가능) */
 void vm_init (void);
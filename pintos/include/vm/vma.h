@@ -0,0 +1,45 @@
+#ifndef VM_VMA_H
+#define VM_VMA_H
+#include <stdbool.h>
+#include <stddef.h>
+#include "filesys/off_t.h"
+#include "vm/vm.h"
+
+/* 가상 메모리 영역 (VMA).
+ * 실행 파일 세그먼트나 mmap처럼 같은 방식으로 채워지는 연속된 페이지 묶음을
+ * 영역 하나로 기록해 두고, struct page는 그 페이지에 처음 폴트가 났을 때 만든다.
+ * 영역끼리는 겹치지 않으므로 시작 주소로 정렬한 AVL 트리가 그대로 구간 트리 역할을 한다:
+ * 주소 조회와 겹침 검사 모두 O(log 영역 수). */
+
+struct file;
+
+struct vma {
+	void *start;				/* 첫 페이지 VA */
+	void *end;					/* 마지막 페이지 다음 VA (배타) */
+	enum vm_type type;			/* 실체화될 페이지 타입 (VM_ANON / VM_FILE) */
+	bool writable;
+	vm_initializer *init;		/* 첫 폴트 때 페이지를 채울 로더 (NULL이면 제로필) */
+	struct file *file;			/* 이 영역 전용으로 reopen한 핸들 (익명 영역이면 NULL) */
+	off_t ofs;					/* start에 대응하는 파일 오프셋 */
+	size_t file_bytes;			/* start부터 파일에서 읽을 바이트 수, 나머지는 0 */
+
+	struct vma *left, *right;	/* AVL 자식 */
+	int height;
+};
+
+struct vma_tree {
+	struct vma *root;
+	size_t cnt;
+};
+
+void vma_tree_init (struct vma_tree *);
+bool vma_map (struct vma_tree *, void *start, size_t page_cnt,
+		enum vm_type type, bool writable, vm_initializer *init,
+		struct file *file, off_t ofs, size_t file_bytes);
+struct vma *vma_find (struct vma_tree *, const void *va);
+bool vma_overlaps (struct vma_tree *, const void *start, const void *end);
+void vma_unmap (struct vma_tree *, void *start);
+bool vma_tree_copy (struct vma_tree *dst, struct vma_tree *src);
+void vma_tree_destroy (struct vma_tree *);
+
+#endif /* vm/vma.h */
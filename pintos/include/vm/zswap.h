@@ -0,0 +1,25 @@
+#ifndef VM_ZSWAP_H
+#define VM_ZSWAP_H
+#include <stdbool.h>
+#include <stddef.h>
+
+/* 압축 스왑 풀 (zswap).
+ * 익명 페이지를 퇴출할 때 스왑 슬롯은 그대로 잡되, 내용은 압축해서 커널 풀의
+ * 아레나 페이지에 보관하고 디스크에는 쓰지 않는다. 풀이 가득 차면 가장 오래된
+ * 항목부터 압축을 풀어 원래 슬롯에 기록(writeback)해 자리를 만든다.
+ * 잘 압축되지 않는 페이지는 바로 디스크로 간다. 항목은 슬롯 번호로 찾는다. */
+
+/* -zswap=N: 압축 풀에 쓸 커널 페이지 수 상한 (0이면 끔) */
+extern size_t zswap_max_pages;
+
+void zswap_init (size_t slot_cnt);
+bool zswap_store (size_t slot, const void *kva);
+bool zswap_load (size_t slot, void *kva);
+bool zswap_peek (size_t slot, void *kva);
+void zswap_invalidate (size_t slot);
+bool zswap_contains (size_t slot);
+
+struct sys_stats;
+void zswap_get_stats (struct sys_stats *);
+
+#endif /* vm/zswap.h */
@@ -0,0 +1,159 @@
+/* Pairing heap.
+
+   See heap.h for basic information.
+
+   The heap is a multiway tree stored in leftmost-child,
+   right-sibling form.  Two heaps are combined ("melded") by
+   making the root with the larger key the leftmost child of the
+   other.  Removing the top melds its children pairwise left to
+   right, then folds the results together right to left, which
+   gives the O(log n) amortized bound. */
+
+#include "heap.h"
+#include "../debug.h"
+
+static struct heap_elem *meld (struct heap *,
+		struct heap_elem *, struct heap_elem *);
+static struct heap_elem *merge_pairs (struct heap *, struct heap_elem *);
+
+/* Initializes heap H as an empty heap ordered by LESS, given
+   auxiliary data AUX. */
+void
+heap_init (struct heap *h, heap_less_func *less, void *aux) {
+	ASSERT (h != NULL);
+	ASSERT (less != NULL);
+
+	h->root = NULL;
+	h->elem_cnt = 0;
+	h->less = less;
+	h->aux = aux;
+}
+
+/* Inserts E into H. */
+void
+heap_insert (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+
+	e->child = e->sibling = e->prev = NULL;
+	h->root = meld (h, h->root, e);
+	h->elem_cnt++;
+}
+
+/* Returns the top element of H, or a null pointer if H is
+   empty. */
+struct heap_elem *
+heap_top (const struct heap *h) {
+	ASSERT (h != NULL);
+
+	return h->root;
+}
+
+/* Removes and returns the top element of H, or returns a null
+   pointer if H is empty. */
+struct heap_elem *
+heap_pop (struct heap *h) {
+	struct heap_elem *top = h->root;
+
+	if (top != NULL)
+		heap_remove (h, top);
+	return top;
+}
+
+/* Removes E, which must be in H, from H. */
+void
+heap_remove (struct heap *h, struct heap_elem *e) {
+	ASSERT (h != NULL);
+	ASSERT (e != NULL);
+	ASSERT (h->elem_cnt > 0);
+
+	if (e == h->root)
+		h->root = merge_pairs (h, e->child);
+	else {
+		/* Unlink E (and its subtree) from its sibling list, then
+		   meld E's children back in at the root. */
+		ASSERT (e->prev != NULL);
+		if (e->prev->child == e)
+			e->prev->child = e->sibling;
+		else
+			e->prev->sibling = e->sibling;
+		if (e->sibling != NULL)
+			e->sibling->prev = e->prev;
+		h->root = meld (h, h->root, merge_pairs (h, e->child));
+	}
+	e->child = e->sibling = e->prev = NULL;
+	h->elem_cnt--;
+}
+
+/* Returns the number of elements in H. */
+size_t
+heap_size (const struct heap *h) {
+	return h->elem_cnt;
+}
+
+/* Returns true if H contains no elements, false otherwise. */
+bool
+heap_empty (const struct heap *h) {
+	return h->root == NULL;
+}
+
+/* Melds the trees rooted at A and B, either of which may be
+   null, and returns the new root.  A and B must have no
+   siblings. */
+static struct heap_elem *
+meld (struct heap *h, struct heap_elem *a, struct heap_elem *b) {
+	if (a == NULL)
+		return b;
+	if (b == NULL)
+		return a;
+	if (h->less (b, a, h->aux)) {
+		struct heap_elem *tmp = a;
+		a = b;
+		b = tmp;
+	}
+
+	b->prev = a;
+	b->sibling = a->child;
+	if (a->child != NULL)
+		a->child->prev = b;
+	a->child = b;
+	return a;
+}
+
+/* Combines the sibling list starting at FIRST into a single tree
+   and returns its root, or a null pointer if FIRST is null. */
+static struct heap_elem *
+merge_pairs (struct heap *h, struct heap_elem *first) {
+	struct heap_elem *pairs = NULL;
+	struct heap_elem *root = NULL;
+
+	/* Left to right: meld adjacent pairs, pushing each result on
+	   a stack threaded through the sibling pointers. */
+	while (first != NULL) {
+		struct heap_elem *a = first;
+		struct heap_elem *b = a->sibling;
+		struct heap_elem *m;
+
+		first = b != NULL ? b->sibling : NULL;
+		a->sibling = a->prev = NULL;
+		if (b != NULL)
+			b->sibling = b->prev = NULL;
+
+		m = meld (h, a, b);
+		m->sibling = pairs;
+		pairs = m;
+	}
+
+	/* Right to left: fold the stack into one tree. */
+	while (pairs != NULL) {
+		struct heap_elem *next = pairs->sibling;
+
+		pairs->sibling = NULL;
+		root = meld (h, root, pairs);
+		pairs = next;
+	}
+
+	if (root != NULL)
+		root->prev = NULL;
+	return root;
+}
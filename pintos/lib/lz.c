@@ -0,0 +1,197 @@
+#include <lz.h>
+#include <debug.h>
+#include <string.h>
+
+/* Compressed format.
+
+   The output is a series of sequences.  Each sequence is a
+   token byte, optional extra literal-length bytes, the
+   literals themselves, and then, except in the last sequence,
+   a 2-byte little-endian match offset and optional extra
+   match-length bytes.  The token's high nibble is the literal
+   count and its low nibble the match length minus
+   LZ_MIN_MATCH; a nibble of 15 means more length follows as a
+   run of bytes ending with the first byte that is not 255,
+   all of which are added to it.  A match copies from OFFSET
+   bytes back in the output and may overlap itself, which is
+   how long runs such as zero-filled memory shrink to a few
+   bytes.  The last sequence ends the input right after its
+   literals. */
+
+#define LZ_MIN_MATCH 4
+
+/* Output buffer being appended to. */
+struct lz_out {
+	uint8_t *buf;
+	size_t ofs;
+	size_t size;
+};
+
+/* Reads 4 bytes at P as a little-endian integer. */
+static uint32_t
+read32 (const uint8_t *p) {
+	return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t) p[3] << 24);
+}
+
+/* Hashes the 4-byte sequence SEQ into the match table. */
+static unsigned
+hash_seq (uint32_t seq) {
+	return (seq * 2654435761u) >> (32 - LZ_HASH_BITS);
+}
+
+/* Appends byte B to OUT.  Returns false if OUT is full. */
+static bool
+put_byte (struct lz_out *out, uint8_t b) {
+	if (out->ofs >= out->size)
+		return false;
+	out->buf[out->ofs++] = b;
+	return true;
+}
+
+/* Appends the extra length bytes that encode LEN beyond a
+   nibble of 15. */
+static bool
+put_length (struct lz_out *out, size_t len) {
+	for (; len >= 255; len -= 255)
+		if (!put_byte (out, 255))
+			return false;
+	return put_byte (out, len);
+}
+
+/* Appends a sequence of LIT_CNT literals from LIT followed by a
+   match of MATCH_LEN bytes at OFFSET bytes back.  MATCH_LEN is 0
+   for the last sequence, which has no match.  Returns false if
+   OUT is too small. */
+static bool
+put_sequence (struct lz_out *out, const uint8_t *lit, size_t lit_cnt,
+		size_t offset, size_t match_len) {
+	size_t lit_code = lit_cnt < 15 ? lit_cnt : 15;
+	size_t match_code = 0;
+
+	if (match_len > 0) {
+		match_code = match_len - LZ_MIN_MATCH;
+		if (match_code > 15)
+			match_code = 15;
+	}
+	if (!put_byte (out, (lit_code << 4) | match_code))
+		return false;
+	if (lit_code == 15 && !put_length (out, lit_cnt - 15))
+		return false;
+
+	if (lit_cnt > out->size - out->ofs)
+		return false;
+	memcpy (out->buf + out->ofs, lit, lit_cnt);
+	out->ofs += lit_cnt;
+
+	if (match_len == 0)
+		return true;
+	if (!put_byte (out, offset & 0xff) || !put_byte (out, offset >> 8))
+		return false;
+	return match_code < 15 || put_length (out, match_len - LZ_MIN_MATCH - 15);
+}
+
+/* Compresses the SRC_SIZE bytes at SRC into the DST_SIZE bytes
+   at DST, using WORK as scratch space.  Returns the compressed
+   size, or 0 if the result would not fit in DST_SIZE bytes, in
+   which case the caller should store the data uncompressed. */
+size_t
+lz_compress (const void *src_, size_t src_size,
+		void *dst, size_t dst_size, struct lz_work *work) {
+	const uint8_t *src = src_;
+	struct lz_out out;
+	size_t pos, anchor;
+
+	ASSERT (src_size <= LZ_MAX_INPUT);
+
+	out.buf = dst;
+	out.ofs = 0;
+	out.size = dst_size;
+	memset (work->table, 0, sizeof work->table);
+
+	pos = anchor = 0;
+	while (pos + LZ_MIN_MATCH <= src_size) {
+		uint32_t seq = read32 (src + pos);
+		unsigned h = hash_seq (seq);
+		size_t cand = work->table[h];
+		size_t ref, len;
+
+		work->table[h] = pos + 1;
+		if (cand == 0 || read32 (src + cand - 1) != seq) {
+			pos++;
+			continue;
+		}
+
+		/* Extend the match as far as it goes. */
+		ref = cand - 1;
+		len = LZ_MIN_MATCH;
+		while (pos + len < src_size && src[ref + len] == src[pos + len])
+			len++;
+
+		if (!put_sequence (&out, src + anchor, pos - anchor, pos - ref, len))
+			return 0;
+		pos += len;
+		anchor = pos;
+	}
+
+	if (!put_sequence (&out, src + anchor, src_size - anchor, 0, 0))
+		return 0;
+	return out.ofs;
+}
+
+/* Reads extra length bytes from SRC at *POS, adding them to
+   *LEN.  Returns false if SRC ends first. */
+static bool
+get_length (const uint8_t *src, size_t src_size, size_t *pos, size_t *len) {
+	uint8_t b;
+
+	do {
+		if (*pos >= src_size)
+			return false;
+		b = src[(*pos)++];
+		*len += b;
+	} while (b == 255);
+	return true;
+}
+
+/* Decompresses the SRC_SIZE bytes at SRC, which lz_compress()
+   produced, into DST.  Returns true if that yields exactly
+   DST_SIZE bytes, false if the input is malformed or the
+   output size differs. */
+bool
+lz_decompress (const void *src_, size_t src_size, void *dst_, size_t dst_size) {
+	const uint8_t *src = src_;
+	uint8_t *dst = dst_;
+	size_t pos = 0, ofs = 0;
+
+	while (pos < src_size) {
+		uint8_t token = src[pos++];
+		size_t lit_cnt = token >> 4;
+		size_t match_len = (token & 15) + LZ_MIN_MATCH;
+		size_t offset;
+
+		if (lit_cnt == 15 && !get_length (src, src_size, &pos, &lit_cnt))
+			return false;
+		if (lit_cnt > src_size - pos || lit_cnt > dst_size - ofs)
+			return false;
+		memcpy (dst + ofs, src + pos, lit_cnt);
+		pos += lit_cnt;
+		ofs += lit_cnt;
+
+		if (pos == src_size)
+			break;                          /* Last sequence. */
+
+		if (src_size - pos < 2)
+			return false;
+		offset = src[pos] | (src[pos + 1] << 8);
+		pos += 2;
+		if ((token & 15) == 15 && !get_length (src, src_size, &pos, &match_len))
+			return false;
+		if (offset == 0 || offset > ofs || match_len > dst_size - ofs)
+			return false;
+
+		/* Byte by byte, since the match may overlap itself. */
+		for (; match_len > 0; match_len--, ofs++)
+			dst[ofs] = dst[ofs - offset];
+	}
+	return ofs == dst_size;
+}
@@ -1,8 +1,23 @@
 #include <string.h>
 #include <debug.h>
+#include <stdint.h>
+
+/* Blocks shorter than this are handled with plain byte loops:
+   the start-up cost of a `rep' string instruction is larger than
+   the copy itself for tiny blocks. */
+#define STRING_SMALL 32
+
+/* 64-bit word that may live at any address and alias any type. */
+typedef uint64_t unaligned_u64 __attribute__ ((may_alias, aligned (1)));
 
 /* Copies SIZE bytes from SRC to DST, which must not overlap.
-   Returns DST. */
+   Returns DST.
+
+   Bulk data is moved 8 bytes at a time with `rep movsq' and the
+   remaining tail with `rep movsb'.  On CPUs with ERMS ("enhanced
+   rep movsb/stosb") the microcode moves whole cache lines per
+   iteration.  SSE is not used: the kernel is built with -mno-sse
+   and does not save FPU/SSE state on context switch. */
 void *
 memcpy (void *dst_, const void *src_, size_t size) {
 	unsigned char *dst = dst_;
@@ -11,8 +26,18 @@ memcpy (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = *src++;
+	if (size < STRING_SMALL) {
+		while (size-- > 0)
+			*dst++ = *src++;
+		return dst_;
+	}
+
+	size_t qwords = size / 8;
+	size_t bytes = size % 8;
+	asm volatile ("rep movsq"
+			: "+D" (dst), "+S" (src), "+c" (qwords) : : "memory");
+	asm volatile ("rep movsb"
+			: "+D" (dst), "+S" (src), "+c" (bytes) : : "memory");
 
 	return dst_;
 }
@@ -27,23 +52,36 @@ memmove (void *dst_, const void *src_, size_t size) {
 	ASSERT (dst != NULL || size == 0);
 	ASSERT (src != NULL || size == 0);
 
-	if (dst < src) {
-		while (size-- > 0)
-			*dst++ = *src++;
-	} else {
-		dst += size;
-		src += size;
-		while (size-- > 0)
-			*--dst = *--src;
+	/* A forward copy is safe unless DST starts inside SRC. */
+	if (dst <= src || dst >= src + size)
+		return memcpy (dst_, src_, size);
+
+	/* Copy backward: the unaligned tail first, byte by byte, then
+	   the rest 8 bytes at a time with the direction flag set.  The
+	   flag is cleared again before returning, as the ABI requires. */
+	dst += size;
+	src += size;
+	size_t bytes = size % 8;
+	size_t qwords = size / 8;
+	while (bytes-- > 0)
+		*--dst = *--src;
+	if (qwords > 0) {
+		dst -= 8;
+		src -= 8;
+		asm volatile ("std; rep movsq; cld"
+				: "+D" (dst), "+S" (src), "+c" (qwords) : : "memory");
 	}
 
-	return dst;
+	return dst_;
 }
 
 /* Find the first differing byte in the two blocks of SIZE bytes
    at A and B.  Returns a positive value if the byte in A is
    greater, a negative value if the byte in B is greater, or zero
-   if blocks A and B are equal. */
+   if blocks A and B are equal.
+
+   Equal prefixes are skipped 8 bytes at a time; only the word
+   that differs is compared byte by byte. */
 int
 memcmp (const void *a_, const void *b_, size_t size) {
 	const unsigned char *a = a_;
@@ -52,6 +90,14 @@ memcmp (const void *a_, const void *b_, size_t size) {
 	ASSERT (a != NULL || size == 0);
 	ASSERT (b != NULL || size == 0);
 
+	while (size >= 8) {
+		if (*(const unaligned_u64 *) a != *(const unaligned_u64 *) b)
+			break;
+		a += 8;
+		b += 8;
+		size -= 8;
+	}
+
 	for (; size-- > 0; a++, b++)
 		if (*a != *b)
 			return *a > *b ? +1 : -1;
@@ -260,8 +306,21 @@ memset (void *dst_, int value, size_t size) {
 
 	ASSERT (dst != NULL || size == 0);
 
-	while (size-- > 0)
-		*dst++ = value;
+	if (size < STRING_SMALL) {
+		while (size-- > 0)
+			*dst++ = value;
+		return dst_;
+	}
+
+	/* Replicate the byte into all 8 lanes and store a word at a
+	   time with `rep stosq', then the tail with `rep stosb'. */
+	uint64_t pattern = (unsigned char) value * 0x0101010101010101ULL;
+	size_t qwords = size / 8;
+	size_t bytes = size % 8;
+	asm volatile ("rep stosq"
+			: "+D" (dst), "+c" (qwords) : "a" (pattern) : "memory");
+	asm volatile ("rep stosb"
+			: "+D" (dst), "+c" (bytes) : "a" (pattern) : "memory");
 
 	return dst_;
 }
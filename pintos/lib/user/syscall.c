@@ -194,3 +194,18 @@ int
 umount (const char *path) {
 	return syscall1 (SYS_UMOUNT, path);
 }
+
+bool
+vmstat (struct vm_stats *st) {
+	return syscall1 (SYS_VMSTAT, st);
+}
+
+bool
+sysstat (struct sys_stats *st) {
+	return syscall2 (SYS_SYSSTAT, st, sizeof *st);
+}
+
+int64_t
+clock_ns (void) {
+	return syscall0 (SYS_CLOCK);
+}
@@ -0,0 +1,171 @@
+/* Test and microbenchmark for the block functions in lib/string.c
+   and the page helpers in threads/mmu.c.
+
+   Verifies memcpy(), memmove(), memset() and memcmp() against
+   simple byte-at-a-time reference loops for many sizes and
+   alignments, then times the library versions (and copy_page(),
+   clear_page()) against those loops on whole pages.
+
+   This is not a test we will run on your submitted projects.
+   It is here for completeness.
+*/
+
+#undef NDEBUG
+#include <debug.h>
+#include <inttypes.h>
+#include <random.h>
+#include <stdio.h>
+#include <string.h>
+#include "devices/timer.h"
+#include "threads/mmu.h"
+#include "threads/palloc.h"
+#include "threads/vaddr.h"
+#include "threads/test.h"
+
+/* Largest block size verified, in bytes. */
+#define MAX_SIZE 300
+
+/* Number of page-sized operations per timed run. */
+#define BENCH_ITERS 20000
+
+static void ref_memcpy (void *, const void *, size_t);
+static void ref_memset (void *, int, size_t);
+static int ref_memcmp (const void *, const void *, size_t);
+static void verify (void);
+static void bench (void);
+
+/* Test and time the block functions. */
+void
+test (void)
+{
+  verify ();
+  bench ();
+  printf ("string: PASS\n");
+}
+
+/* Checks the library block functions against the reference loops
+   for every size up to MAX_SIZE and every alignment mod 8. */
+static void
+verify (void)
+{
+  static uint8_t src[MAX_SIZE + 16], dst[MAX_SIZE + 16], ref[MAX_SIZE + 16];
+  size_t size, s_ofs, d_ofs;
+
+  printf ("verifying block functions:");
+  for (size = 0; size <= MAX_SIZE; size = size < 40 ? size + 1 : size * 5 / 4)
+    {
+      printf (" %zu", size);
+      for (s_ofs = 0; s_ofs < 8; s_ofs++)
+        for (d_ofs = 0; d_ofs < 8; d_ofs++)
+          {
+            size_t i;
+
+            for (i = 0; i < sizeof src; i++)
+              src[i] = random_ulong ();
+            ref_memset (dst, 0x5a, sizeof dst);
+            ref_memset (ref, 0x5a, sizeof ref);
+
+            /* memcpy. */
+            ASSERT (memcpy (dst + d_ofs, src + s_ofs, size) == dst + d_ofs);
+            ref_memcpy (ref + d_ofs, src + s_ofs, size);
+            ASSERT (ref_memcmp (dst, ref, sizeof dst) == 0);
+
+            /* memcmp, including a difference in the last byte. */
+            ASSERT (memcmp (dst + d_ofs, src + s_ofs, size) == 0);
+            if (size > 0)
+              {
+                dst[d_ofs + size - 1] ^= 0x80;
+                ASSERT (memcmp (dst + d_ofs, src + s_ofs, size)
+                        == ref_memcmp (dst + d_ofs, src + s_ofs, size));
+                dst[d_ofs + size - 1] ^= 0x80;
+              }
+
+            /* memset. */
+            ASSERT (memset (dst + d_ofs, s_ofs, size) == dst + d_ofs);
+            ref_memset (ref + d_ofs, s_ofs, size);
+            ASSERT (ref_memcmp (dst, ref, sizeof dst) == 0);
+
+            /* memmove in both directions within one buffer. */
+            if (size + 8 <= sizeof dst)
+              {
+                ref_memcpy (dst, src, sizeof dst);
+                ref_memcpy (ref, src, sizeof ref);
+                ASSERT (memmove (dst + d_ofs, dst + s_ofs, size) == dst + d_ofs);
+                for (i = 0; i < size; i++)
+                  ASSERT (dst[d_ofs + i] == ref[s_ofs + i]);
+              }
+          }
+    }
+  printf (" done\n");
+}
+
+/* Times one page-sized operation, BENCH_ITERS times, and prints
+   the elapsed timer ticks. */
+#define TIME(NAME, STMT)                                        \
+  do                                                            \
+    {                                                           \
+      int64_t start = timer_ticks ();                           \
+      int i;                                                    \
+      for (i = 0; i < BENCH_ITERS; i++)                         \
+        STMT;                                                   \
+      printf ("  %-12s %6"PRId64" ticks\n",                     \
+              NAME, timer_elapsed (start));                     \
+    }                                                           \
+  while (0)
+
+/* Compares the library functions with the reference loops on
+   whole pages. */
+static void
+bench (void)
+{
+  void *a = palloc_get_page (PAL_ASSERT);
+  void *b = palloc_get_page (PAL_ASSERT);
+
+  printf ("timing %d page operations:\n", BENCH_ITERS);
+  TIME ("byte copy", ref_memcpy (a, b, PGSIZE));
+  TIME ("memcpy", memcpy (a, b, PGSIZE));
+  TIME ("copy_page", copy_page (a, b));
+  TIME ("byte set", ref_memset (a, 0, PGSIZE));
+  TIME ("memset", memset (a, 0, PGSIZE));
+  TIME ("clear_page", clear_page (a));
+  TIME ("byte cmp", ref_memcmp (a, b, PGSIZE));
+  TIME ("memcmp", memcmp (a, b, PGSIZE));
+  TIME ("memmove", memmove ((uint8_t *) a + 8, a, PGSIZE - 8));
+
+  palloc_free_page (a);
+  palloc_free_page (b);
+}
+
+/* Reference byte-at-a-time memcpy(). */
+static void
+ref_memcpy (void *dst_, const void *src_, size_t size)
+{
+  volatile uint8_t *dst = dst_;
+  const uint8_t *src = src_;
+
+  while (size-- > 0)
+    *dst++ = *src++;
+}
+
+/* Reference byte-at-a-time memset(). */
+static void
+ref_memset (void *dst_, int value, size_t size)
+{
+  volatile uint8_t *dst = dst_;
+
+  while (size-- > 0)
+    *dst++ = value;
+}
+
+/* Reference byte-at-a-time memcmp(). */
+static int
+ref_memcmp (const void *a_, const void *b_, size_t size)
+{
+  const volatile uint8_t *a = a_;
+  const uint8_t *b = b_;
+
+  for (; size-- > 0; a++, b++)
+    if (*a != *b)
+      return *a > *b ? +1 : -1;
+  return 0;
+}
@@ -0,0 +1,44 @@
+/* Checks that reading untouched BSS pages maps the shared zero
+   page instead of allocating a frame per page, and that the
+   first write to one of them gets a private frame. */
+
+#include <string.h>
+#include <syscall.h>
+#include <stdio.h>
+#include <stdint.h>
+#include "tests/lib.h"
+#include "tests/main.h"
+
+#define PAGE_SIZE 4096
+#define CHUNK_PAGE_COUNT 4
+#define CHUNK_SIZE (CHUNK_PAGE_COUNT * PAGE_SIZE)
+
+static char buf[CHUNK_SIZE] __attribute__ ((aligned (PAGE_SIZE)));
+
+void
+test_main (void)
+{
+	struct vm_stats before, after;
+	size_t i;
+	int sum = 0;
+
+	// Fault in the code and stack this test uses before sampling.
+	CHECK (vmstat (&before), "vmstat");
+
+	msg ("read bss pages");
+	vmstat (&before);
+	for (i = 0 ; i < CHUNK_PAGE_COUNT ; i++)
+		sum += buf[i*PAGE_SIZE];
+	vmstat (&after);
+	CHECK (sum == 0, "check memory content");
+	CHECK (after.resident_pages == before.resident_pages,
+	       "check if no frame was allocated");
+
+	msg ("write bss page");
+	vmstat (&before);
+	buf[0] = 1;
+	vmstat (&after);
+	CHECK (buf[0] == 1, "check memory content");
+	CHECK (after.resident_pages == before.resident_pages + 1,
+	       "check if one frame was allocated");
+}
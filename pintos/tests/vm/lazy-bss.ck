@@ -0,0 +1,16 @@
+# -*- perl -*-
+use strict;
+use warnings;
+use tests::tests;
+check_expected (IGNORE_EXIT_CODES => 1, [<<'EOF']);
+(lazy-bss) begin
+(lazy-bss) vmstat
+(lazy-bss) read bss pages
+(lazy-bss) check memory content
+(lazy-bss) check if no frame was allocated
+(lazy-bss) write bss page
+(lazy-bss) check memory content
+(lazy-bss) check if one frame was allocated
+(lazy-bss) end
+EOF
+pass;
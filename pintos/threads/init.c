@@ -20,6 +20,9 @@
 #include "threads/mmu.h"
 #include "threads/palloc.h"
 #include "threads/pte.h"
+#include "threads/profile.h"
+#include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/thread.h"
 #ifdef USERPROG
 #include "userprog/process.h"
@@ -86,6 +89,8 @@ main (void) {
 	mem_end = palloc_init ();
 	malloc_init ();
 	paging_init (mem_end);
+	profile_init ();
+	trace_init ();
 
 #ifdef USERPROG
 	tss_init ();
@@ -221,11 +226,31 @@ parse_options (char **argv) {
 			random_init (atoi (value));
 		else if (!strcmp (name, "-mlfqs"))
 			thread_mlfqs = true;
+		else if (!strcmp (name, "-tickless"))
+			timer_tickless = true;
+		else if (!strcmp (name, "-profile"))
+			profile_enabled = true;
+		else if (!strcmp (name, "-trace"))
+			trace_enabled = true;
+#ifdef LOCKSTAT
+		else if (!strcmp (name, "-lockstat"))
+			lockstat_enabled = true;
+#endif
 #ifdef USERPROG
 		else if (!strcmp (name, "-ul"))
 			user_page_limit = atoi (value);
 		else if (!strcmp (name, "-threads-tests"))
 			thread_tests = true;
+#endif
+#ifdef VM
+		else if (!strcmp (name, "-vmstat"))
+			vmstat_enabled = true;
+		else if (!strcmp (name, "-swapra"))
+			swap_readahead_max = atoi (value);
+		else if (!strcmp (name, "-faultaround"))
+			fault_around_max = atoi (value);
+		else if (!strcmp (name, "-zswap"))
+			zswap_max_pages = atoi (value);
 #endif
 		else
 			PANIC ("unknown option `%s' (use -h for help)", name);
@@ -326,8 +351,20 @@ usage (void) {
 			"  -f                 Format file system disk during startup.\n"
 			"  -rs=SEED           Set random number seed to SEED.\n"
 			"  -mlfqs             Use multi-level feedback queue scheduler.\n"
+			"  -tickless          Skip timer ticks while the CPU is idle.\n"
+			"  -profile           Sample timer interrupts and print a profile.\n"
+			"  -trace             Record tracepoints and dump them at power off.\n"
+#ifdef LOCKSTAT
+			"  -lockstat          Print lock contention statistics at power off.\n"
+#endif
 #ifdef USERPROG
 			"  -ul=COUNT          Limit user memory to COUNT pages.\n"
+#endif
+#ifdef VM
+			"  -vmstat            Print VM statistics as each process exits.\n"
+			"  -swapra=N          Read ahead up to N swap slots per swap fault.\n"
+			"  -faultaround=N     Map up to N following file pages on a file fault.\n"
+			"  -zswap=N           Keep up to N pages of compressed swap in memory.\n"
 #endif
 			);
 	power_off ();
@@ -362,4 +399,9 @@ print_stats (void) {
 #ifdef USERPROG
 	exception_print_stats ();
 #endif
+#ifdef LOCKSTAT
+	lockstat_print ();
+#endif
+	profile_print ();
+	trace_dump ();
 }
@@ -96,7 +96,7 @@ uint64_t *
 pml4_create (void) {
 	uint64_t *pml4 = palloc_get_page (0);
 	if (pml4)
-		memcpy (pml4, base_pml4, PGSIZE);
+		copy_page (pml4, base_pml4);
 	return pml4;
 }
 
@@ -312,3 +312,31 @@ pml4_set_accessed (uint64_t *pml4, const void *vpage, bool accessed) {
 			invlpg ((uint64_t) vpage);
 	}
 }
+
+/* Copies the PGSIZE bytes of page SRC to page DST.  Both must be
+ * page-aligned kernel virtual addresses.  The whole page is moved
+ * with a single `rep movsq', which avoids memcpy()'s size and
+ * tail handling on the hottest copy path (fork, page-table
+ * creation). */
+void
+copy_page (void *dst, const void *src) {
+	size_t cnt = PGSIZE / sizeof (uint64_t);
+
+	ASSERT (pg_ofs (dst) == 0);
+	ASSERT (pg_ofs (src) == 0);
+
+	asm volatile ("rep movsq"
+			: "+D" (dst), "+S" (src), "+c" (cnt) : : "memory");
+}
+
+/* Fills the page-aligned page at KPAGE with zeros using a single
+ * `rep stosq'. */
+void
+clear_page (void *kpage) {
+	size_t cnt = PGSIZE / sizeof (uint64_t);
+
+	ASSERT (pg_ofs (kpage) == 0);
+
+	asm volatile ("rep stosq"
+			: "+D" (kpage), "+c" (cnt) : "a" (0ULL) : "memory");
+}
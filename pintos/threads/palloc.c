@@ -189,6 +189,8 @@ populate_pools (struct area *base_mem, struct area *ext_mem) {
 
 	// generate the user pool
 	init_pool(&user_pool, &free_start, region_start, end);
+	lock_set_name (&kernel_pool.lock, "kernel_pool");
+	lock_set_name (&user_pool.lock, "user_pool");
 
 	// Iterate over the e820_entry. Setup the usable.
 	uint64_t usable_bound = (uint64_t) free_start;
@@ -328,6 +330,19 @@ palloc_free_page (void *page) {
 	palloc_free_multiple (page, 1);
 }
 
+/* Returns the number of free pages in the user pool if FLAGS
+   has PAL_USER, otherwise in the kernel pool. */
+size_t
+palloc_free_cnt (enum palloc_flags flags) {
+	struct pool *pool = flags & PAL_USER ? &user_pool : &kernel_pool;
+	size_t cnt;
+
+	lock_acquire (&pool->lock);
+	cnt = bitmap_count (pool->used_map, 0, bitmap_size (pool->used_map), false);
+	lock_release (&pool->lock);
+	return cnt;
+}
+
 /* Initializes pool P as starting at START and ending at END */
 static void
 init_pool (struct pool *p, void **bm_base, uint64_t start, uint64_t end) {
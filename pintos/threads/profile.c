@@ -0,0 +1,168 @@
+#include "threads/profile.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+
+/* Timer-interrupt sampling profiler.
+
+   With -profile, every timer interrupt records the interrupted
+   RIP, whether it was in user or kernel mode and the running
+   thread's tid into a ring buffer allocated at boot, so the last
+   PROFILE_PAGES pages' worth of samples are kept.  At power off,
+   profile_print() prints the hottest kernel addresses followed
+   by a "Profile addresses:" line that can be pasted into
+   utils/backtrace to symbolize them, the same way as a "Call
+   stack:" line. */
+
+bool profile_enabled;
+
+#define PROFILE_PAGES 16        /* Ring buffer size, in pages. */
+#define PROFILE_TOP 32          /* Kernel addresses to report. */
+
+/* One sample. */
+struct profile_sample {
+	uint64_t rip;               /* Interrupted instruction. */
+	int32_t tid;                /* Running thread. */
+	uint32_t user;              /* Nonzero if RIP is in user mode. */
+};
+
+static struct profile_sample *samples;  /* Ring buffer. */
+static size_t sample_cap;               /* Capacity of SAMPLES. */
+static size_t sample_head;              /* Next slot to write. */
+static uint64_t sample_total;           /* Samples taken, including overwritten. */
+
+/* A histogram bucket. */
+struct profile_hit {
+	uint64_t rip;
+	size_t cnt;
+};
+
+static int sample_rip_cmp (const void *, const void *);
+static int sample_tid_cmp (const void *, const void *);
+
+/* Allocates the sample buffer.  Called once the page allocator
+   is up; does nothing unless -profile was given. */
+void
+profile_init (void) {
+	if (!profile_enabled)
+		return;
+
+	samples = palloc_get_multiple (PAL_ZERO, PROFILE_PAGES);
+	if (samples == NULL) {
+		printf ("profile: out of memory, profiling disabled\n");
+		profile_enabled = false;
+		return;
+	}
+	sample_cap = PROFILE_PAGES * PGSIZE / sizeof *samples;
+}
+
+/* Records one sample for the interrupt frame F.  Called from the
+   timer interrupt handler. */
+void
+profile_sample (const struct intr_frame *f) {
+	struct profile_sample *s;
+
+	if (samples == NULL)
+		return;
+
+	s = &samples[sample_head];
+	s->rip = f->rip;
+	s->user = (f->cs & 3) == 3;
+	s->tid = thread_current ()->tid;
+	if (++sample_head == sample_cap)
+		sample_head = 0;
+	sample_total++;
+}
+
+/* Prints the profile.  Sorts the sample buffer in place, so no
+   samples should be taken afterward. */
+void
+profile_print (void) {
+	struct profile_hit top[PROFILE_TOP];
+	size_t top_cnt = 0;
+	size_t cnt, kernel_cnt, i, j;
+
+	if (samples == NULL)
+		return;
+
+	/* 정렬 중 새 샘플이 끼어들지 않도록 끔 */
+	enum intr_level old_level = intr_disable ();
+	profile_enabled = false;
+	cnt = sample_total < sample_cap ? sample_total : sample_cap;
+	qsort (samples, cnt, sizeof *samples, sample_rip_cmp);
+	intr_set_level (old_level);
+
+	/* 커널 샘플은 앞쪽에 RIP 순으로 모여 있음: 같은 RIP 구간을 세어 상위 N개 유지 */
+	for (i = 0; i < cnt && !samples[i].user; i = j) {
+		size_t run;
+
+		for (j = i; j < cnt && !samples[j].user && samples[j].rip == samples[i].rip; j++)
+			continue;
+		run = j - i;
+
+		if (top_cnt < PROFILE_TOP)
+			top_cnt++;
+		else if (run <= top[top_cnt - 1].cnt)
+			continue;
+
+		/* 삽입 정렬로 내림차순 유지 */
+		size_t k = top_cnt - 1;
+		for (; k > 0 && top[k - 1].cnt < run; k--)
+			top[k] = top[k - 1];
+		top[k].rip = samples[i].rip;
+		top[k].cnt = run;
+	}
+	kernel_cnt = i;
+
+	printf ("Profile: %zu samples (%zu kernel, %zu user)",
+			cnt, kernel_cnt, cnt - kernel_cnt);
+	if (sample_total > cnt)
+		printf (", %"PRIu64" older samples dropped", sample_total - cnt);
+	printf ("\n");
+	for (i = 0; i < top_cnt; i++)
+		printf ("  %8zu %3zu%%  %#018"PRIx64"\n",
+				top[i].cnt, top[i].cnt * 100 / cnt, top[i].rip);
+
+	/* 스레드별 커널/유저 샘플 수 */
+	qsort (samples, cnt, sizeof *samples, sample_tid_cmp);
+	for (i = 0; i < cnt; i = j) {
+		size_t user = 0;
+
+		for (j = i; j < cnt && samples[j].tid == samples[i].tid; j++)
+			user += samples[j].user != 0;
+		printf ("  tid %d: %zu kernel, %zu user\n",
+				samples[i].tid, j - i - user, user);
+	}
+
+	/* utils/backtrace에 그대로 붙여넣을 수 있는 형식 */
+	printf ("Profile addresses:");
+	for (i = 0; i < top_cnt; i++)
+		printf (" %#"PRIx64, top[i].rip);
+	printf ("\n");
+}
+
+/* Orders samples kernel before user, then by RIP. */
+static int
+sample_rip_cmp (const void *a_, const void *b_) {
+	const struct profile_sample *a = a_;
+	const struct profile_sample *b = b_;
+
+	if (a->user != b->user)
+		return a->user < b->user ? -1 : 1;
+	if (a->rip != b->rip)
+		return a->rip < b->rip ? -1 : 1;
+	return 0;
+}
+
+/* Orders samples by tid. */
+static int
+sample_tid_cmp (const void *a_, const void *b_) {
+	const struct profile_sample *a = a_;
+	const struct profile_sample *b = b_;
+
+	return a->tid < b->tid ? -1 : a->tid > b->tid;
+}
@@ -27,17 +27,45 @@
    */
 
 #include "threads/synch.h"
+#include <inttypes.h>
 #include <stdio.h>
 #include <string.h>
 #include "threads/interrupt.h"
 #include "threads/thread.h"
+#ifdef LOCKSTAT
+#include "devices/timer.h"
+#endif
+
+static bool donor_more (const struct heap_elem *, const struct heap_elem *,
+		void *aux);
+static int lock_top_donation (struct lock *);
+static void lock_take (struct lock *);
+static void propagate_donation (struct lock *);
+static bool cond_waiter_more (const struct heap_elem *,
+		const struct heap_elem *, void *aux);
+
+#ifdef LOCKSTAT
+/* Counters for every lock with one name. */
+struct lockstat {
+	const char *name;           /* Lock name. */
+	uint64_t acquires;          /* Successful acquisitions. */
+	uint64_t contended;         /* Acquisitions that had to wait. */
+	int64_t wait_ticks;         /* Total ticks spent waiting. */
+	int64_t max_wait;           /* Longest single wait. */
+	int64_t hold_ticks;         /* Total ticks held. */
+	int64_t max_hold;           /* Longest single hold. */
+};
+
+#define LOCKSTAT_CNT 32         /* Maximum number of distinct names. */
+static struct lockstat lockstats[LOCKSTAT_CNT];
+static size_t lockstat_cnt;
 
-static bool donations_contains (struct list *lst, struct thread *t);
-static void propagate_donation(struct thread *donor);
+/* -lockstat: record lock statistics? */
+bool lockstat_enabled;
 
-static bool cond_waiter_more_prio(const struct list_elem *a,
-                                  const struct list_elem *b,
-                                  void *aux);
+static void lockstat_acquired (struct lock *, bool contended, int64_t wait_start);
+static void lockstat_released (struct lock *);
+#endif
 
 /* Initializes semaphore SEMA to VALUE.  A semaphore is a
    nonnegative integer along with two atomic operators for
@@ -201,6 +229,12 @@ lock_init (struct lock *lock) {
 
 	lock->holder = NULL;
 	sema_init (&lock->semaphore, 1);
+	heap_init (&lock->donors, donor_more, NULL);
+	lock->donation = PRI_MIN - 1;
+#ifdef LOCKSTAT
+	lock->stat = NULL;
+	lock->acquired_at = 0;
+#endif
 }
 
 /* Acquires LOCK, sleeping until it becomes available if
@@ -217,14 +251,20 @@ lock_acquire (struct lock *lock) {
 	ASSERT (!intr_context ());
 	ASSERT (!lock_held_by_current_thread (lock));
 
+	struct thread *cur = thread_current ();
 	enum intr_level old = intr_disable();
 
-	if (lock->holder != NULL && thread_current() != lock->holder) {
-		/* 현재 스레드는 이 lock을 기다린다. */
-		thread_current()->wait_on_lock = lock;
-
-		/* donation 전파 (H->...->L) */
-		propagate_donation(thread_current());
+#ifdef LOCKSTAT
+	bool contended = lock->holder != NULL;
+	int64_t wait_start = lockstat_enabled && lock->stat != NULL ? timer_ticks () : 0;
+#endif
+
+	/* MLFQS에서는 우선순위 기부를 하지 않는다. */
+	if (!thread_mlfqs && lock->holder != NULL) {
+		/* 현재 스레드는 이 lock을 기다린다: donors heap에 넣고 기부 전파 */
+		cur->wait_on_lock = lock;
+		heap_insert (&lock->donors, &cur->donor_elem);
+		propagate_donation (lock);
 	}
 
 	intr_set_level(old);
@@ -233,8 +273,17 @@ lock_acquire (struct lock *lock) {
 	sema_down (&lock->semaphore);
 
 	/* lock을 얻었으므로 더는 대기 아님 */
-	thread_current()->wait_on_lock = NULL;
-	lock->holder = thread_current ();
+	old = intr_disable ();
+	if (cur->wait_on_lock != NULL) {
+		heap_remove (&lock->donors, &cur->donor_elem);
+		cur->wait_on_lock = NULL;
+	}
+	intr_set_level (old);
+
+	lock_take (lock);
+#ifdef LOCKSTAT
+	lockstat_acquired (lock, contended, wait_start);
+#endif
 }
 
 /* Tries to acquires LOCK and returns true if successful or false
@@ -251,8 +300,12 @@ lock_try_acquire (struct lock *lock) {
 	ASSERT (!lock_held_by_current_thread (lock));
 
 	success = sema_try_down (&lock->semaphore);
-	if (success)
-		lock->holder = thread_current ();
+	if (success) {
+		lock_take (lock);
+#ifdef LOCKSTAT
+		lockstat_acquired (lock, false, 0);
+#endif
+	}
 	return success;
 }
 
@@ -267,14 +320,22 @@ lock_release (struct lock *lock) { /* 락 회수 */
 	ASSERT (lock != NULL);
 	ASSERT (lock_held_by_current_thread (lock));
 
-	/* 1) 이 lock 때문에 받았던 donation 제거 */
-	thread_remove_donations_for_lock(thread_current(), lock);
+#ifdef LOCKSTAT
+	lockstat_released (lock);
+#endif
+	enum intr_level old = intr_disable ();
 
-	/* 2) 내 effective priority 재계산 (남은 donation + base) */
-	thread_refresh_priority(thread_current());
+	if (!thread_mlfqs) {
+		/* 1) 이 lock을 통해 받던 기부 제거: held_locks에서 빼기 - O(log n) */
+		heap_remove (&thread_current ()->held_locks, &lock->held_elem);
+
+		/* 2) 내 effective priority 재계산 (남은 lock들의 기부 + base) */
+		thread_refresh_priority (thread_current ());
+	}
 
 	/* 3) 실제로 lock을 반납하고 대기자 깨우기 */
 	lock->holder = NULL;
+	intr_set_level (old);
 	sema_up (&lock->semaphore);
 }
 
@@ -288,12 +349,116 @@ lock_held_by_current_thread (const struct lock *lock) {
 	return lock->holder == thread_current ();
 }
 
-/* One semaphore in a list. */
+/* Initializes RW as unlocked. */
+void
+rwlock_init (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_init (&rw->writer);
+	sema_init (&rw->drained, 0);
+	rw->readers = 0;
+	rw->writer_waiting = false;
+}
+
+/* Acquires RW for reading, sleeping while a writer holds it or
+   is waiting for it.  Other readers may hold RW at the same
+   time.  Must not be called within an interrupt handler, and a
+   thread must not take RW for reading twice (a writer queued in
+   between would deadlock it). */
+void
+rwlock_acquire_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+	ASSERT (!intr_context ());
+	ASSERT (!lock_held_by_current_thread (&rw->writer));
+
+	/* fast path: 쓰는 중이거나 기다리는 writer가 없으면 카운터만 올림 */
+	old_level = intr_disable ();
+	if (rw->writer.holder == NULL && list_empty (&rw->writer.semaphore.waiters)) {
+		rw->readers++;
+		intr_set_level (old_level);
+		return;
+	}
+	intr_set_level (old_level);
+
+	/* slow path: writer lock을 거쳐 writer 뒤에 줄 섬 (그 사이 writer에게 기부) */
+	lock_acquire (&rw->writer);
+	old_level = intr_disable ();
+	rw->readers++;
+	intr_set_level (old_level);
+	lock_release (&rw->writer);
+}
+
+/* Releases RW, which the current thread must hold for reading.
+   The last reader out wakes a waiting writer. */
+void
+rwlock_release_read (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	old_level = intr_disable ();
+	ASSERT (rw->readers > 0);
+	if (--rw->readers == 0 && rw->writer_waiting) {
+		rw->writer_waiting = false;
+		sema_up (&rw->drained);
+	}
+	intr_set_level (old_level);
+}
+
+/* Acquires RW for writing, sleeping until no other writer holds
+   it and all current readers have released it.  New readers are
+   held off from the moment this is called.  Must not be called
+   within an interrupt handler. */
+void
+rwlock_acquire_write (struct rwlock *rw) {
+	enum intr_level old_level;
+
+	ASSERT (rw != NULL);
+
+	lock_acquire (&rw->writer);
+
+	/* 이미 들어와 있던 reader들이 다 나갈 때까지 대기 */
+	old_level = intr_disable ();
+	while (rw->readers > 0) {
+		rw->writer_waiting = true;
+		sema_down (&rw->drained);
+	}
+	intr_set_level (old_level);
+}
+
+/* Releases RW, which the current thread must hold for writing. */
+void
+rwlock_release_write (struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	lock_release (&rw->writer);
+}
+
+/* Returns true if the current thread holds RW for writing. */
+bool
+rwlock_held_for_write (const struct rwlock *rw) {
+	ASSERT (rw != NULL);
+
+	return lock_held_by_current_thread (&rw->writer);
+}
+
+/* One semaphore in a list.
+   조건 변수의 대기자 하나. 깨울 스레드와 그 우선순위(heap 키)를 직접 들고 있어
+   cond_signal()이 세마포어 내부 waiters를 뒤질 필요가 없다. */
 struct semaphore_elem {
-	struct list_elem elem;              /* List element. */
+	struct heap_elem elem;              /* cond->waiters의 원소. */
 	struct semaphore semaphore;         /* This semaphore. */
+	struct condition *cond;             /* 기다리는 조건 변수. */
+	struct thread *thread;              /* 기다리는 스레드. */
+	int priority;                       /* heap 키: thread의 유효 우선순위. */
+	uint64_t seq;                       /* 대기 시작 순서: 같은 우선순위면 먼저 온 쪽부터. */
 };
 
+/* cond_wait()마다 1씩 늘어나는 대기 순번 (인터럽트 off에서 갱신). */
+static uint64_t cond_seq;
+
 /* Initializes condition variable COND.  A condition variable
    allows one piece of code to signal a condition and cooperating
    code to receive the signal and act upon it. */
@@ -301,7 +466,7 @@ void
 cond_init (struct condition *cond) {
 	ASSERT (cond != NULL);
 
-	list_init (&cond->waiters);
+	heap_init (&cond->waiters, cond_waiter_more, NULL);
 }
 
 /* Atomically releases LOCK and waits for COND to be signaled by
@@ -327,6 +492,8 @@ cond_init (struct condition *cond) {
 void
 cond_wait (struct condition *cond, struct lock *lock) {
 	struct semaphore_elem waiter;
+	struct thread *cur = thread_current ();
+	enum intr_level old_level;
 
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
@@ -335,7 +502,17 @@ cond_wait (struct condition *cond, struct lock *lock) {
 
 	/* 의도적으로 0으로 초기화 후 */
 	sema_init (&waiter.semaphore, 0);
-	list_push_back (&cond->waiters, &waiter.elem);
+	waiter.cond = cond;
+	waiter.thread = cur;
+
+	/* donation 전파가 인터럽트 off 상태에서 이 heap을 재정렬하므로 같은 규칙을 따름 */
+	old_level = intr_disable ();
+	waiter.priority = cur->priority;
+	waiter.seq = cond_seq++;
+	heap_insert (&cond->waiters, &waiter.elem);
+	cur->cond_waiter = &waiter;
+	intr_set_level (old_level);
+
 	lock_release (lock);
 	/* 스스로 잠들기 위함 */
 	sema_down (&waiter.semaphore);
@@ -357,13 +534,18 @@ cond_signal (struct condition *cond, struct lock *lock UNUSED) {
 	ASSERT (!intr_context ());
 	ASSERT (lock_held_by_current_thread (lock));
 
-	if (!list_empty (&cond->waiters)) {
-		/* 현재 시점의 유효 우선순위 기준으로 가장 높은 waiter 선택 */
-		list_sort (&(cond->waiters), cond_waiter_more_prio, NULL);
-		struct semaphore_elem *se =
-			list_entry (list_pop_front (&cond->waiters), struct semaphore_elem, elem);
-		sema_up (&(se->semaphore));
+	/* heap top이 현재 유효 우선순위가 가장 높은 waiter - O(log n) */
+	enum intr_level old_level = intr_disable ();
+	struct semaphore_elem *se = NULL;
+
+	if (!heap_empty (&cond->waiters)) {
+		se = heap_entry (heap_pop (&cond->waiters), struct semaphore_elem, elem);
+		se->thread->cond_waiter = NULL;
 	}
+	intr_set_level (old_level);
+
+	if (se != NULL)
+		sema_up (&(se->semaphore));
 }
 
 /* Wakes up all threads, if any, waiting on COND (protected by
@@ -377,83 +559,195 @@ cond_broadcast (struct condition *cond, struct lock *lock) {
 	ASSERT (cond != NULL);
 	ASSERT (lock != NULL);
 
-	while (!list_empty (&cond->waiters))
+	while (!heap_empty (&cond->waiters))
 		cond_signal (cond, lock);
 }
 
-/* Return true if list 'lst' already contains thread t via donation_elem. */
+/* T의 유효 우선순위가 바뀌었을 때 호출: T가 조건 변수를 기다리는 중이면
+   그 waiters heap에서 키를 갱신한다. 인터럽트 off 상태에서 호출해야 함. */
+void
+cond_resort_waiter (struct thread *t) {
+	struct semaphore_elem *se = t->cond_waiter;
+
+	if (se == NULL || se->priority == t->priority)
+		return;
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	heap_remove (&se->cond->waiters, &se->elem);
+	se->priority = t->priority;
+	heap_insert (&se->cond->waiters, &se->elem);
+}
+
+/* donors 정렬: priority가 큰 대기자가 top */
 static bool
-donations_contains (struct list *lst, struct thread *t) {
-	struct list_elem *e;
-	for (e = list_begin (lst); e != list_end (lst); e = list_next (e)) {
-		if (list_entry (e, struct thread, donation_elem) == t) {
-			return true;
-		}
+donor_more (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct thread, donor_elem)->priority
+		> heap_entry (b, struct thread, donor_elem)->priority;
+}
+
+/* LOCK의 현재 기부값: 최고 우선순위 대기자의 priority (없으면 PRI_MIN - 1) */
+static int
+lock_top_donation (struct lock *lock) {
+	if (heap_empty (&lock->donors))
+		return PRI_MIN - 1;
+	return heap_entry (heap_top (&lock->donors), struct thread, donor_elem)->priority;
+}
+
+/* LOCK을 현재 스레드 소유로 기록하고 holder의 held_locks에 등록.
+   남아있는 대기자들의 기부가 새 holder에게 바로 반영된다. */
+static void
+lock_take (struct lock *lock) {
+	struct thread *cur = thread_current ();
+	enum intr_level old = intr_disable ();
+
+	lock->holder = cur;
+	if (!thread_mlfqs) {
+		lock->donation = lock_top_donation (lock);
+		heap_insert (&cur->held_locks, &lock->held_elem);
+		thread_refresh_priority (cur);
 	}
-	return false;
+
+	intr_set_level (old);
 }
 
-/* donor(=current)가 어떤 lock을 기다릴 때, holder 체인으로 우선순위를 전파 */
-static void 
-propagate_donation(struct thread *donor) {
+/* LOCK의 donors가 바뀐 뒤 호출: 기부값을 다시 계산하고 holder 체인(H->...->L)으로 전파.
+   각 단계는 heap 재삽입 + O(1) refresh이므로 O(log n), 값이 안 바뀌면 즉시 멈춤. */
+static void
+propagate_donation (struct lock *lock) {
 	int depth = 0;
-	struct lock *lock = donor->wait_on_lock;
 
-	while (lock && depth++ < 8) { /* 깊이 제한 8 -> 순환/무한 전파 방지 */
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	while (lock != NULL && depth++ < 8) { /* 깊이 제한 8 -> 순환/무한 전파 방지 */
 		struct thread *holder = lock->holder;
-		if (holder == NULL) break;
+		int donation = lock_top_donation (lock);
 
-		/* 1) holder의 donations에 donor를 연결 
-			  -> 중복 방지: donor->donation_elem이 이미 들어가 있다면 재삽입 X */
-		if (!donations_contains(&(holder->donations), donor)) {
-			/* 정렬 유지 안함. 최댓값은 refresh_priority가 전체 순회로 해결. */
-			list_push_back(&(holder->donations), &(donor->donation_elem));
-		}
-    	
-		/* 2) holder의 effective priority를 donor 기준으로 끌어올림 */
-		int before = holder->priority;
-		thread_refresh_priority(holder);
+		if (donation == lock->donation)
+			break;
 
-		/* 3) holder가 ready_list 안에 있으면 재정렬 */
-		if (holder->priority != before) {
-			thread_resort_ready_member(holder);
+		/* 반납 직후 아직 새 holder가 없으면 held_locks에 없음 */
+		if (holder == NULL) {
+			lock->donation = donation;
+			break;
 		}
 
-		/* 4) 다음 단계(중첩 기부): holder도 어떤 lock을 기다리면 체인 위로 계속 */
-		lock = holder->wait_on_lock;
+		/* 1) holder의 held_locks에서 이 lock의 키 갱신 */
+		heap_remove (&holder->held_locks, &lock->held_elem);
+		lock->donation = donation;
+		heap_insert (&holder->held_locks, &lock->held_elem);
 
-		/* 다음 단계 donor는 holder로 갱신 */
-		donor = holder;
+		/* 2) holder의 effective priority 재계산 (대기 중인 lock의 donors 키, run queue 위치 포함) */
+		int before = holder->priority;
+		thread_refresh_priority (holder);
+		if (holder->priority == before)
+			break;
+
+		/* 3) 다음 단계(중첩 기부): holder도 어떤 lock을 기다리면 체인 위로 계속 */
+		lock = holder->wait_on_lock;
 	}
 }
 
-/* condvar의 각 원소 semephore_elem 안에는 개별 세마포어가 있고,
-   실제로 잠들어 있는 스레드는 sema_elem.semaphore.waiters에 있다.
-   즉, cond_signal()에서 누굴 깨울지는 각 semaphore_elem이 깨어나게 만들 대상 스레드의 우선순위로 비교해야 한다.
-*/
-static bool 
-cond_waiter_more_prio(const struct list_elem *a, const struct list_elem *b, void *aux) {
-	const struct semaphore_elem *sa = list_entry(a, struct semaphore_elem, elem);
-	const struct semaphore_elem *sb = list_entry(b, struct semaphore_elem, elem);
-	int pa = PRI_MIN, pb = PRI_MIN;
-
-	/* sa 내부 대기자 중 최대 priority */
-	for (struct list_elem *e = list_begin(&(sa->semaphore.waiters));
-		 e != list_end(&(sa->semaphore.waiters)); e = list_next(e)) {
-		int pr = list_entry(e, struct thread, elem)->priority;
-		if (pr > pa) {
-			pa = pr;
-		} 
-	}
+/* cond->waiters 정렬: 우선순위가 큰 waiter가 top.
+   pairing heap은 같은 키의 삽입 순서를 지키지 않으므로 순번으로 FIFO를 보장 */
+static bool
+cond_waiter_more (const struct heap_elem *a_, const struct heap_elem *b_,
+		void *aux UNUSED) {
+	const struct semaphore_elem *a = heap_entry (a_, struct semaphore_elem, elem);
+	const struct semaphore_elem *b = heap_entry (b_, struct semaphore_elem, elem);
+	if (a->priority != b->priority)
+		return a->priority > b->priority;
+	return a->seq < b->seq;
+}
 
-	/* sb 내부 대기자 중 최대 priority */
-	for (struct list_elem *e = list_begin(&(sb->semaphore.waiters));
-		 e != list_end(&(sb->semaphore.waiters)); e = list_next(e)) {
-		int pr = list_entry(e, struct thread, elem)->priority;
-		if (pr > pb) {
-			pb = pr;
-		} 
+#ifdef LOCKSTAT
+/* Names LOCK for the contention report.  Locks with the same
+   NAME share one set of counters.  NAME must stay valid (a
+   string literal, normally). */
+void
+lock_set_name (struct lock *lock, const char *name) {
+	enum intr_level old_level;
+	size_t i;
+
+	ASSERT (lock != NULL);
+	ASSERT (name != NULL);
+
+	old_level = intr_disable ();
+	for (i = 0; i < lockstat_cnt; i++)
+		if (!strcmp (lockstats[i].name, name))
+			break;
+	if (i == lockstat_cnt && lockstat_cnt < LOCKSTAT_CNT)
+		lockstats[lockstat_cnt++].name = name;
+	lock->stat = i < lockstat_cnt ? &lockstats[i] : NULL;
+	intr_set_level (old_level);
+}
+
+/* Records that the current thread has just acquired LOCK, after
+   waiting since WAIT_START if CONTENDED. */
+static void
+lockstat_acquired (struct lock *lock, bool contended, int64_t wait_start) {
+	struct lockstat *ls = lock->stat;
+
+	if (!lockstat_enabled || ls == NULL)
+		return;
+
+	enum intr_level old_level = intr_disable ();
+	int64_t now = timer_ticks ();
+
+	ls->acquires++;
+	if (contended) {
+		int64_t waited = now - wait_start;
+
+		ls->contended++;
+		ls->wait_ticks += waited;
+		if (waited > ls->max_wait)
+			ls->max_wait = waited;
 	}
-	
-	return pa > pb;
-}
\ No newline at end of file
+	lock->acquired_at = now;
+	intr_set_level (old_level);
+}
+
+/* Records that the current thread is about to release LOCK. */
+static void
+lockstat_released (struct lock *lock) {
+	struct lockstat *ls = lock->stat;
+
+	if (!lockstat_enabled || ls == NULL)
+		return;
+
+	enum intr_level old_level = intr_disable ();
+	int64_t held = timer_ticks () - lock->acquired_at;
+
+	ls->hold_ticks += held;
+	if (held > ls->max_hold)
+		ls->max_hold = held;
+	intr_set_level (old_level);
+}
+
+/* Prints the lock contention report. */
+void
+lockstat_print (void) {
+	struct lockstat snap[LOCKSTAT_CNT];
+	size_t cnt, i;
+
+	if (!lockstat_enabled)
+		return;
+
+	/* 출력 중 console_lock 등이 카운터를 바꾸므로 먼저 스냅샷 */
+	enum intr_level old_level = intr_disable ();
+	cnt = lockstat_cnt;
+	memcpy (snap, lockstats, cnt * sizeof *snap);
+	intr_set_level (old_level);
+
+	printf ("Lock statistics (ticks):\n");
+	printf ("  %-16s %10s %10s %10s %8s %10s %8s\n", "name", "acquires",
+			"contended", "wait", "max", "hold", "max");
+	for (i = 0; i < cnt; i++)
+		printf ("  %-16s %10"PRIu64" %10"PRIu64" %10"PRId64" %8"PRId64
+				" %10"PRId64" %8"PRId64"\n",
+				snap[i].name, snap[i].acquires, snap[i].contended,
+				snap[i].wait_ticks, snap[i].max_wait,
+				snap[i].hold_ticks, snap[i].max_hold);
+}
+#endif /* LOCKSTAT */
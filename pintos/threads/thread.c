@@ -3,14 +3,18 @@
 #include <stddef.h>
 #include <random.h>
 #include <stdio.h>
+#include <stats.h>
 #include <string.h>			/* memset */
+#include "threads/fixed-point.h"
 #include "threads/flags.h"
 #include "threads/interrupt.h"
 #include "threads/intr-stubs.h"
 #include "threads/palloc.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"
 #include "intrinsic.h"
+#include "devices/timer.h"
 #ifdef USERPROG
 #include "userprog/process.h"
 #endif
@@ -24,9 +28,17 @@
    Do not modify this value. */
 #define THREAD_BASIC 0xd42df210
 
-/* List of processes in THREAD_READY state, that is, processes
-   that are ready to run but not actually running. */
-static struct list ready_list;
+/* Run queue: processes in THREAD_READY state, that is, processes
+   that are ready to run but not actually running.
+   우선순위별 FIFO 큐 64개 + 비어있지 않은 큐를 표시하는 64비트 마스크.
+   bit p가 1이면 ready_queues[p]에 스레드가 하나 이상 있음.
+   -> 삽입/최고 우선순위 선택 모두 O(1) (__builtin_clzll). */
+static struct list ready_queues[PRI_MAX + 1];
+static uint64_t ready_mask;
+static int ready_cnt;           /* run queue에 있는 스레드 수 (load_avg 계산용). */
+
+/* 살아있는 모든 스레드 목록 (MLFQS의 1초/4틱 재계산용). */
+static struct list all_list;
 
 /* Idle thread. */
 static struct thread *idle_thread;
@@ -44,6 +56,7 @@ static struct list destruction_req;
 static long long idle_ticks;    /* # of timer ticks spent idle. */
 static long long kernel_ticks;  /* # of timer ticks in kernel threads. */
 static long long user_ticks;    /* # of timer ticks in user programs. */
+static long long switch_cnt;    /* # of switches to a different thread. */
 
 /* Scheduling. */
 #define TIME_SLICE 4            /* # of timer ticks to give each thread. */
@@ -54,6 +67,9 @@ static unsigned thread_ticks;   /* # of timer ticks since last yield. */
    Controlled by kernel command-line option "-o mlfqs". */
 bool thread_mlfqs;
 
+/* MLFQS: 최근 1분간 실행 가능했던 스레드 수의 지수 이동 평균. */
+static fixed_t load_avg;
+
 static void kernel_thread (thread_func *, void *aux);
 
 static void idle (void *aux UNUSED);
@@ -62,6 +78,14 @@ static void init_thread (struct thread *, const char *name, int priority);
 static void do_schedule(int status);
 static void schedule (void);
 static tid_t allocate_tid (void);
+static void ready_queue_push (struct thread *);
+static void ready_queue_remove (struct thread *);
+static int ready_queue_max_priority (void);
+static bool held_lock_more (const struct heap_elem *,
+		const struct heap_elem *, void *aux);
+static void mlfqs_tick (struct thread *);
+static void mlfqs_update_priority (struct thread *);
+static void mlfqs_update_recent_cpu (struct thread *);
 
 /* Returns true if T appears to point to a valid thread. */
 #define is_thread(t) ((t) != NULL && (t)->magic == THREAD_MAGIC)
@@ -107,7 +131,13 @@ thread_init (void) {
 
 	/* Init the globla thread context */
 	lock_init (&tid_lock);
-	list_init (&ready_list);
+	lock_set_name (&tid_lock, "tid_lock");
+	for (int pri = PRI_MIN; pri <= PRI_MAX; pri++)
+		list_init (&ready_queues[pri]);
+	ready_mask = 0;
+	ready_cnt = 0;
+	list_init (&all_list);
+	load_avg = 0;
 	list_init (&destruction_req);
 
 	/* Set up a thread structure for the running thread. */
@@ -149,6 +179,9 @@ thread_tick (void) {
 	else
 		kernel_ticks++;
 
+	if (thread_mlfqs)
+		mlfqs_tick (t);
+
 	/* Enforce preemption. */
 	if (++thread_ticks >= TIME_SLICE)
 		intr_yield_on_return ();
@@ -161,6 +194,17 @@ thread_print_stats (void) {
 			idle_ticks, kernel_ticks, user_ticks);
 }
 
+/* Fills in the scheduler fields of ST. */
+void
+thread_get_stats (struct sys_stats *st) {
+	enum intr_level old_level = intr_disable ();
+	st->idle_ticks = idle_ticks;
+	st->kernel_ticks = kernel_ticks;
+	st->user_ticks = user_ticks;
+	st->context_switches = switch_cnt;
+	intr_set_level (old_level);
+}
+
 /* Creates a new kernel thread named NAME with the given initial
    PRIORITY, which executes FUNCTION passing AUX as the argument,
    and adds it to the ready queue.  Returns the thread identifier
@@ -193,6 +237,13 @@ thread_create (const char *name, int priority,
 	init_thread (t, name, priority);
 	tid = t->tid = allocate_tid ();
 
+	/* MLFQS: nice/recent_cpu는 부모에게서 물려받고, 우선순위는 인자 대신 계산값 사용 */
+	if (thread_mlfqs) {
+		t->nice = thread_current ()->nice;
+		t->recent_cpu = thread_current ()->recent_cpu;
+		mlfqs_update_priority (t);
+	}
+
 	/* Call the kernel_thread if it scheduled.
 	 * Note) rdi is 1st argument, and rsi is 2nd argument. */
 	t->tf.rip = (uintptr_t) kernel_thread;
@@ -226,6 +277,7 @@ thread_block (void) {
 	ASSERT (!intr_context ());
 	ASSERT (intr_get_level () == INTR_OFF);
 	thread_current ()->status = THREAD_BLOCKED;
+	TRACE (TRACE_BLOCK, __builtin_return_address (0), 0, 0);
 	schedule ();
 }
 
@@ -246,10 +298,11 @@ thread_unblock (struct thread *t) {
 	old_level = intr_disable ();
 	ASSERT (t->status == THREAD_BLOCKED);
 
-	/* ready_list에 정렬 삽입 적용 */
-	list_insert_ordered(&ready_list, &t->elem, thread_cmp_priority, NULL);
+	/* 자기 우선순위 큐의 맨 뒤에 삽입 (같은 우선순위끼리는 FIFO) */
+	ready_queue_push (t);
 
 	t->status = THREAD_READY;
+	TRACE (TRACE_UNBLOCK, t->tid, t->priority, 0);
 	intr_set_level (old_level);
 }
 
@@ -296,6 +349,7 @@ thread_exit (void) {
 	/* Just set our status to dying and schedule another process.
 	   We will be destroyed during the call to schedule_tail(). */
 	intr_disable ();
+	list_remove (&thread_current ()->all_elem);
 	do_schedule (THREAD_DYING);
 	NOT_REACHED ();
 }
@@ -312,8 +366,8 @@ thread_yield (void) {
 	old_level = intr_disable ();
 
 	if (curr != idle_thread)
-		/* ready로 되돌릴 때도 정렬 삽입 */
-		list_insert_ordered (&ready_list, &curr->elem, thread_cmp_priority, NULL);
+		/* ready로 되돌릴 때도 자기 우선순위 큐의 맨 뒤로 */
+		ready_queue_push (curr);
 
 	do_schedule (THREAD_READY);
 	intr_set_level (old_level);
@@ -322,20 +376,19 @@ thread_yield (void) {
 /* Sets the current thread's priority to NEW_PRIORITY. */
 void
 thread_set_priority (int new_priority) {
+	/* MLFQS에서는 스케줄러가 우선순위를 직접 관리하므로 무시 */
+	if (thread_mlfqs)
+		return;
+
 	enum intr_level old = intr_disable();
 	struct thread *cur = thread_current();
 
 	cur->base_priority = new_priority;
-	thread_refresh_priority(cur);			/* donation 고려한 effective 반영 */
-	thread_resort_ready_member(cur);		/* ready_list 안에 있었다면 재정렬 */
+	thread_refresh_priority(cur);			/* donation 고려한 effective 반영 (큐 이동 포함) */
 
 	/* 내가 더 이상 최고 우선순위가 아니라면 즉시 양보 */
-	if (!list_empty(&ready_list)) {
-		struct thread *top = list_entry(list_front(&ready_list), struct thread, elem);
-		
-		if (top->priority > cur->priority) {
-			thread_yield();
-		}
+	if (ready_queue_max_priority () > cur->priority) {
+		thread_yield();
 	}
 
 	intr_set_level(old);
@@ -349,29 +402,113 @@ thread_get_priority (void) {
 
 /* Sets the current thread's nice value to NICE. */
 void
-thread_set_nice (int nice UNUSED) {
-	/* TODO: Your implementation goes here */
+thread_set_nice (int nice) {
+	enum intr_level old = intr_disable ();
+	struct thread *cur = thread_current ();
+
+	if (nice < NICE_MIN)
+		nice = NICE_MIN;
+	if (nice > NICE_MAX)
+		nice = NICE_MAX;
+	cur->nice = nice;
+
+	/* mlfqs에서 nice가 바뀌면 우선순위를 즉시 재계산, 최고가 아니게 되면 양보.
+	 * 우선순위 스케줄러에서는 nice가 우선순위에 영향을 주지 않음 */
+	if (thread_mlfqs) {
+		mlfqs_update_priority (cur);
+		if (ready_queue_max_priority () > cur->priority)
+			thread_yield ();
+	}
+
+	intr_set_level (old);
 }
 
 /* Returns the current thread's nice value. */
 int
 thread_get_nice (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	return thread_current ()->nice;
 }
 
 /* Returns 100 times the system load average. */
 int
 thread_get_load_avg (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old = intr_disable ();
+	int v = fp_to_int_round (fp_mul_int (load_avg, 100));
+	intr_set_level (old);
+	return v;
 }
 
 /* Returns 100 times the current thread's recent_cpu value. */
 int
 thread_get_recent_cpu (void) {
-	/* TODO: Your implementation goes here */
-	return 0;
+	enum intr_level old = intr_disable ();
+	int v = fp_to_int_round (fp_mul_int (thread_current ()->recent_cpu, 100));
+	intr_set_level (old);
+	return v;
+}
+
+/* MLFQS per-tick work, called from thread_tick() with interrupts
+   off.  Only the running thread's recent_cpu changes on an
+   ordinary tick, so that path is O(1).  load_avg and every
+   thread's recent_cpu are recomputed once per second, and
+   priorities once every fourth tick. */
+static void
+mlfqs_tick (struct thread *cur) {
+	int64_t now = timer_ticks ();
+
+	if (cur != idle_thread)
+		cur->recent_cpu = fp_add_int (cur->recent_cpu, 1);
+
+	if (now % TIMER_FREQ == 0) {
+		/* load_avg = (59/60)*load_avg + (1/60)*ready_threads */
+		int ready_threads = ready_cnt + (cur != idle_thread ? 1 : 0);
+		load_avg = fp_add (fp_mul (fp_div_int (fp_from_int (59), 60), load_avg),
+				fp_div_int (fp_from_int (ready_threads), 60));
+
+		for (struct list_elem *e = list_begin (&all_list);
+				e != list_end (&all_list); e = list_next (e))
+			mlfqs_update_recent_cpu (list_entry (e, struct thread, all_elem));
+	}
+
+	if (now % 4 == 0) {
+		for (struct list_elem *e = list_begin (&all_list);
+				e != list_end (&all_list); e = list_next (e))
+			mlfqs_update_priority (list_entry (e, struct thread, all_elem));
+
+		/* 재계산 결과 더 높은 우선순위가 생기면 핸들러 리턴 후 양보 */
+		if (ready_queue_max_priority () > cur->priority)
+			intr_yield_on_return ();
+	}
+}
+
+/* priority = PRI_MAX - (recent_cpu / 4) - (nice * 2), clamped
+   to [PRI_MIN, PRI_MAX].  Moves T to its new run queue if it is
+   ready. */
+static void
+mlfqs_update_priority (struct thread *t) {
+	if (t == idle_thread)
+		return;
+
+	int pri = PRI_MAX - fp_to_int (fp_div_int (t->recent_cpu, 4)) - t->nice * 2;
+	if (pri < PRI_MIN)
+		pri = PRI_MIN;
+	if (pri > PRI_MAX)
+		pri = PRI_MAX;
+
+	t->priority = t->base_priority = pri;
+	thread_resort_ready_member (t);
+	cond_resort_waiter (t);
+}
+
+/* recent_cpu = (2*load_avg)/(2*load_avg + 1) * recent_cpu + nice */
+static void
+mlfqs_update_recent_cpu (struct thread *t) {
+	if (t == idle_thread)
+		return;
+
+	fixed_t twice_load = fp_mul_int (load_avg, 2);
+	fixed_t coeff = fp_div (twice_load, fp_add_int (twice_load, 1));
+	t->recent_cpu = fp_add_int (fp_mul (coeff, t->recent_cpu), t->nice);
 }
 
 /* Idle thread.  Executes when no other thread is ready to run.
@@ -393,8 +530,12 @@ idle (void *idle_started_ UNUSED) {
 	for (;;) {
 		/* Let someone else run. */
 		intr_disable ();
+		timer_idle_exit ();
 		thread_block ();
 
+		/* -tickless: 다음 timeout까지 주기 틱을 건너뜀 */
+		timer_idle_enter ();
+
 		/* Re-enable interrupts and wait for the next one.
 
 		   The `sti' instruction disables interrupts until the
@@ -438,7 +579,15 @@ init_thread (struct thread *t, const char *name, int priority) {
 	t->magic = THREAD_MAGIC;
 
 	t->base_priority = priority;
-	list_init(&(t->donations));
+	heap_init (&t->held_locks, held_lock_more, NULL);
+
+	/* MLFQS 기본값(부모 상속은 thread_create()에서) */
+	t->nice = NICE_DEFAULT;
+	t->recent_cpu = 0;
+	/* 타이머 인터럽트(mlfqs_tick)가 all_list를 순회하므로 끼워 넣는 동안 인터럽트 off */
+	enum intr_level old_level = intr_disable ();
+	list_push_back (&all_list, &t->all_elem);
+	intr_set_level (old_level);
 	t->wait_on_lock = NULL;			// 중복
 	
 #ifdef USERPROG
@@ -471,10 +620,50 @@ init_thread (struct thread *t, const char *name, int priority) {
    idle_thread. */
 static struct thread *
 next_thread_to_run (void) {
-	if (list_empty (&ready_list))
+	if (ready_mask == 0)
 		return idle_thread;
-	else
-		return list_entry (list_pop_front (&ready_list), struct thread, elem);
+	else {
+		struct list *q = &ready_queues[ready_queue_max_priority ()];
+		struct thread *t = list_entry (list_front (q), struct thread, elem);
+		ready_queue_remove (t);
+		return t;
+	}
+}
+
+/* Appends T to the tail of the run queue for its current
+   priority and marks that queue as non-empty.
+   Interrupts must be off. */
+static void
+ready_queue_push (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+	ASSERT (PRI_MIN <= t->priority && t->priority <= PRI_MAX);
+
+	t->ready_priority = t->priority;	/* 나중에 뺄 큐를 기억 (그 사이 donation으로 priority가 바뀔 수 있음) */
+	list_push_back (&ready_queues[t->ready_priority], &t->elem);
+	ready_mask |= 1ULL << t->ready_priority;
+	ready_cnt++;
+}
+
+/* Removes T from the run queue it was pushed to, clearing the
+   queue's bit in ready_mask if it becomes empty.
+   Interrupts must be off. */
+static void
+ready_queue_remove (struct thread *t) {
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	list_remove (&t->elem);
+	if (list_empty (&ready_queues[t->ready_priority]))
+		ready_mask &= ~(1ULL << t->ready_priority);
+	ready_cnt--;
+}
+
+/* Returns the highest priority that has a ready thread, or -1 if
+   the run queue is empty. */
+static int
+ready_queue_max_priority (void) {
+	if (ready_mask == 0)
+		return -1;
+	return 63 - __builtin_clzll (ready_mask);
 }
 
 /* Use iretq to launch the thread */
@@ -604,18 +793,26 @@ schedule (void) {
 	ASSERT (intr_get_level () == INTR_OFF);
 	ASSERT (curr->status != THREAD_RUNNING);
 	ASSERT (is_thread (next));
+	TRACE (TRACE_SCHEDULE, curr->tid, next->tid, curr->status);
 	/* Mark us as running. */
 	next->status = THREAD_RUNNING;
 
 	/* Start new time slice. */
 	thread_ticks = 0;
 
+	/* -tickless: idle을 떠나는 즉시 늘려 둔 PIT 주기를 다음 틱 경계로 줄임.
+	 * 그래야 깨어난 스레드의 틱과 timeout이 밀리지 않음 */
+	if (curr == idle_thread && next != idle_thread)
+		timer_idle_exit ();
+
 #ifdef USERPROG
 	/* Activate the new address space. */
 	process_activate (next);
 #endif
 
 	if (curr != next) {
+		switch_cnt++;
+
 		/* If the thread we switched from is dying, destroy its struct
 		   thread. This must happen late so that thread_exit() doesn't
 		   pull out the rug under itself.
@@ -647,8 +844,8 @@ allocate_tid (void) {
 	return tid;
 }
 
-/* Highest-priority-first ordering for ready_list (no donation yet).
- * ready_list용 비교 함수.
+/* Highest-priority-first ordering for thread lists.
+ * 세마포어 waiters 등 우선순위 정렬 리스트용 비교 함수.
  */
 bool
 thread_cmp_priority (const struct list_elem *a,
@@ -661,44 +858,52 @@ thread_cmp_priority (const struct list_elem *a,
 	return ta->priority > tb->priority; /* 높은 priority가 앞 */
 }
 
-/* (A) 현재 스레드의 effective priority 재계산:
-	base_priority와 donations의 donor들 중 최댓값을 취함. */
+/* (A) t의 effective priority 재계산 - O(1):
+	base_priority와 held_locks top(보유 lock들을 통한 기부 최댓값) 중 큰 값.
+	t가 lock을 기다리는 중이면 그 lock의 donors heap 키도 함께 갱신하고,
+	run queue에 있으면 큐를 옮긴다. 호출 측은 인터럽트를 꺼둔 상태여야 함. */
 void
 thread_refresh_priority(struct thread *t) {
 	int maxp = t->base_priority;
-	/* donations를 순회하며 donor->priority의 최댓값 반영 */
-	struct list_elem *e;
-	for (e = list_begin(&(t->donations)); e != list_end(&(t->donations)); e = list_next(e)) {
-		struct thread *donor = list_entry(e, struct thread, donation_elem);
-		if (donor->priority > maxp) {
-			maxp = donor->priority;
-		}
+
+	ASSERT (intr_get_level () == INTR_OFF);
+
+	if (!heap_empty (&t->held_locks)) {
+		struct lock *top = heap_entry (heap_top (&t->held_locks), struct lock, held_elem);
+		if (top->donation > maxp)
+			maxp = top->donation;
 	}
-	t->priority = maxp;
+	if (maxp == t->priority)
+		return;
+
+	/* heap 원소의 키는 heap 안에서 바꿀 수 없으므로 뺐다가 다시 넣음 */
+	if (t->wait_on_lock != NULL) {
+		heap_remove (&t->wait_on_lock->donors, &t->donor_elem);
+		t->priority = maxp;
+		heap_insert (&t->wait_on_lock->donors, &t->donor_elem);
+	} else
+		t->priority = maxp;
+
+	thread_resort_ready_member (t);
+	cond_resort_waiter (t);
 }
 
-/* (B) t가 보유 중인 lock L 때문에 받았던 donation들을 제거 */
-void
-thread_remove_donations_for_lock(struct thread *t, struct lock *lock) {
-	struct list_elem *e = list_begin(&(t->donations));
-	while (e != list_end(&(t->donations))) {
-		struct thread *donor = list_entry(e, struct thread, donation_elem);
-		struct list_elem *next = list_next(e);
-		if (donor->wait_on_lock == lock) {
-			list_remove(e);
-		}
-		e = next;
-	}
+/* held_locks 정렬: 기부값이 큰 lock이 top */
+static bool
+held_lock_more (const struct heap_elem *a, const struct heap_elem *b,
+		void *aux UNUSED) {
+	return heap_entry (a, struct lock, held_elem)->donation
+		> heap_entry (b, struct lock, held_elem)->donation;
 }
 
-/* (C) ready_list 안에 있는 스레드 t의 위치 재정렬(유효 우선순위 변동 대응) */
+/* (C) run queue 안에 있는 스레드 t를 새 우선순위의 큐로 옮김(유효 우선순위 변동 대응) - O(1) */
 void
 thread_resort_ready_member(struct thread *t) {
 	enum intr_level old = intr_disable();
 
-	if (t->status == THREAD_READY) {
-		list_remove(&(t->elem));
-		list_insert_ordered(&ready_list, &(t->elem), thread_cmp_priority, NULL);
+	if (t->status == THREAD_READY && t->ready_priority != t->priority) {
+		ready_queue_remove(t);
+		ready_queue_push(t);
 	}
 	
 	intr_set_level(old);
@@ -0,0 +1,109 @@
+#include "threads/trace.h"
+#include <inttypes.h>
+#include <stdio.h>
+#include "devices/timer.h"
+#include "threads/interrupt.h"
+#include "threads/palloc.h"
+#include "threads/thread.h"
+#include "threads/vaddr.h"
+#include "intrinsic.h"
+
+/* -trace: record tracepoints. */
+bool trace_enabled;
+
+#define TRACE_PAGES 64          /* Ring buffer size, in pages. */
+
+/* One trace record, dumped byte for byte (little-endian). */
+struct trace_record {
+	uint64_t tsc;               /* Time stamp counter. */
+	uint32_t event;             /* enum trace_event. */
+	int32_t tid;                /* Running thread. */
+	uint64_t arg[3];            /* Event-specific arguments. */
+};
+
+static struct trace_record *records;    /* Ring buffer. */
+static size_t record_cap;               /* Capacity of RECORDS. */
+static size_t record_head;              /* Next slot to write. */
+static uint64_t record_total;           /* Records written, including overwritten. */
+
+/* TSC and tick count when tracing started, so that the decoder
+   can convert TSC deltas into time. */
+static uint64_t start_tsc;
+static int64_t start_ticks;
+
+/* Allocates the trace buffer.  Called once the page allocator is
+   up; does nothing unless -trace was given. */
+void
+trace_init (void) {
+	if (!trace_enabled)
+		return;
+
+	/* 할당 전까지 TRACE()가 기록하지 않도록 잠시 끔 */
+	trace_enabled = false;
+	records = palloc_get_multiple (PAL_ZERO, TRACE_PAGES);
+	if (records == NULL) {
+		printf ("trace: out of memory, tracing disabled\n");
+		return;
+	}
+	record_cap = TRACE_PAGES * PGSIZE / sizeof *records;
+	start_tsc = rdtsc ();
+	start_ticks = timer_ticks ();
+	trace_enabled = true;
+}
+
+/* Appends one record.  Use TRACE() instead of calling this
+   directly.  Safe in interrupt context and inside schedule(). */
+void
+trace_event (enum trace_event event, uint64_t a0, uint64_t a1, uint64_t a2) {
+	/* schedule() 도중에는 thread_current()의 검사가 실패하므로 스택 페이지에서 직접 얻음 */
+	struct thread *t = pg_round_down (rrsp ());
+	enum intr_level old_level = intr_disable ();
+	struct trace_record *r = &records[record_head];
+
+	r->tsc = rdtsc ();
+	r->event = event;
+	r->tid = t->tid;
+	r->arg[0] = a0;
+	r->arg[1] = a1;
+	r->arg[2] = a2;
+	if (++record_head == record_cap)
+		record_head = 0;
+	record_total++;
+	intr_set_level (old_level);
+}
+
+/* Writes the trace buffer to the console, oldest record first,
+   one "T <hex>" line per record between "Trace: begin" and
+   "Trace: end" lines. */
+void
+trace_dump (void) {
+	static const char hex[] = "0123456789abcdef";
+	char line[2 * sizeof (struct trace_record) + 1];
+	size_t cnt, first, i, j;
+
+	if (records == NULL)
+		return;
+
+	enum intr_level old_level = intr_disable ();
+	trace_enabled = false;
+	intr_set_level (old_level);
+
+	cnt = record_total < record_cap ? record_total : record_cap;
+	first = record_total < record_cap ? 0 : record_head;
+
+	printf ("Trace: begin records=%zu dropped=%"PRIu64" tsc0=%"PRIu64
+			" ticks0=%"PRId64" tsc1=%"PRIu64" ticks1=%"PRId64" hz=%d\n",
+			cnt, record_total - cnt, start_tsc, start_ticks,
+			rdtsc (), timer_ticks (), TIMER_FREQ);
+	for (i = 0; i < cnt; i++) {
+		const uint8_t *p = (const uint8_t *) &records[(first + i) % record_cap];
+
+		for (j = 0; j < sizeof (struct trace_record); j++) {
+			line[2 * j] = hex[p[j] >> 4];
+			line[2 * j + 1] = hex[p[j] & 0xf];
+		}
+		line[sizeof line - 1] = '\0';
+		printf ("T %s\n", line);
+	}
+	printf ("Trace: end\n");
+}
@@ -1,5 +1,6 @@
 #include "userprog/exception.h"
 #include <inttypes.h>
+#include <stats.h>
 #include <stdio.h>
 #include "userprog/gdt.h"
 #include "threads/interrupt.h"
@@ -69,6 +70,12 @@ exception_print_stats (void) {
 	printf ("Exception: %lld page faults\n", page_fault_cnt);
 }
 
+/* Fills in the page fault count of ST. */
+void
+exception_get_stats (struct sys_stats *st) {
+	st->page_faults = page_fault_cnt;
+}
+
 /* Handler for an exception (probably) caused by a user process. */
 static void
 kill (struct intr_frame *f) {
@@ -143,8 +150,8 @@ page_fault (struct intr_frame *f) {
 	if (user) {
 		thread_current()->user_rsp = f->rsp;
 	}
-	/* VM 시도: 존재한지 않는 페이지만 복구를 시도 */
-	if (not_present) {
+	/* VM 시도: 존재하지 않는 페이지, 또는 읽기 전용 페이지에 대한 쓰기(제로 페이지) */
+	if (not_present || write) {
 		if (vm_try_handle_fault (f, fault_addr, user, write, not_present))
 			return;		/* 성공적으로 페이지를 채웠으니 복귀 */
 	}
@@ -28,7 +28,7 @@
 #include "threads/synch.h"
 #include "userprog/syscall.h"
 
-extern struct lock fs_lock;         /* filesys.c의 전역 락을 사용(하나만 써야 함) */
+extern struct rwlock fs_lock;         /* filesys.c의 전역 락을 사용(하나만 써야 함) */
 
 static void process_cleanup (void);
 static bool load (const char *file_name, struct intr_frame *if_);
@@ -224,7 +224,7 @@ duplicate_pte (uint64_t *pte, void *va, void *aux) {		/* 부모의 PTE 하나를
 	if (newpage == NULL) return false;
 
 	/* 부모 페이지의 내용을 그대로 자식 새 페이지로 바이트 단위 복사 */
-	memcpy(newpage, parent_page, PGSIZE);
+	copy_page(newpage, parent_page);
 	/* 부모 PTE의 쓰기 가능 플래그를 읽어 동일한 접근권한을 유지 */
 	bool writable = is_writable(pte);
 	
@@ -276,9 +276,9 @@ __do_fork (void *aux_) {							/* 자식 스레드 본체: thread_create가 이
 	for (int fd = 2; fd < FD_MAX; fd++) {			/* 표준입출력 0/1은 이미 세팅되어 있다고 가정, 2부터 복제 */
 		struct file *pf = parent->fd_table[fd];		/* 부모의 fd 엔트리(열린 파일 객체 포인터) 획득 */
 		if (pf != NULL) {							/* 실제로 열려 있는 슬롯만 처리 */
-			lock_acquire(&fs_lock);					/* 파일 시스템 계층은 스레드 안전하지 않으므로 전역 락 획득 */
+			rwlock_acquire_write (&fs_lock);					/* 파일 시스템 계층은 스레드 안전하지 않으므로 전역 락 획득 */
       		struct file *cf = file_duplicate(pf);	/* 부모 파일 객체를 안전하게 복제 */
-      		lock_release(&fs_lock);					/* 크리티컬 섹션 종료 후 락 해제 */
+      		rwlock_release_write (&fs_lock);					/* 크리티컬 섹션 종료 후 락 해제 */
 
 			if (cf == NULL) {
 				ok = false;
@@ -418,9 +418,9 @@ process_cleanup (void) {
 
 	/* 실행파일 핸들 정리: allow_write 자동 포함됨 */
     if (curr->running_exe) {
-        lock_acquire(&fs_lock);
+        rwlock_acquire_write (&fs_lock);
         file_close(curr->running_exe);   // 내부에서 file_allow_write() 호출됨
-        lock_release(&fs_lock);
+        rwlock_release_write (&fs_lock);
         curr->running_exe = NULL;
     }
 
@@ -554,18 +554,18 @@ load (const char *file_name, struct intr_frame *if_) {
 	if (argc == 0) goto done;	// 토큰 0개 처리
 
 	/* 실행 파일 오픈 + 쓰기 금지 설정 + 실행 파일 핸들 저장 */
-	lock_acquire (&fs_lock);
+	rwlock_acquire_write (&fs_lock);
 	file = filesys_open (argv_tok[0]);
 
 	if (file == NULL) {
-		lock_release (&fs_lock);
+		rwlock_release_write (&fs_lock);
 		printf ("load: %s: open failed\n", argv_tok[0]);
 		goto done;
 	}
 
 	file_deny_write (file);			/* 실행 중인 파일에 대한 쓰기 금지 */
 	t->running_exe = file;          /* 현재 스레드에 실행 파일 핸들을 보관 */
-    lock_release (&fs_lock);                                
+    rwlock_release_write (&fs_lock);                                
 
 	/* ELF 헤더 검증 */
 	if (file_read (file, &ehdr, sizeof ehdr) != sizeof ehdr
@@ -686,9 +686,9 @@ done:
 	/* 중요: 성공이면 실행 파일 핸들은 t->running_exe가 보유 → 여기서 닫지 않음.
 	 * 실패면 곧바로 닫아서 deny_write 해제. */
 	if (file && !success) {
-		lock_acquire (&fs_lock);
+		rwlock_acquire_write (&fs_lock);
       	file_close (file);
-      	lock_release (&fs_lock);
+      	rwlock_release_write (&fs_lock);
    }
 
 	return success;
@@ -863,14 +863,16 @@ lazy_load_segment (struct page *page, void *aux_) {
 		fp->ofs = aux->ofs;
 		fp->read_bytes = aux->read_bytes;
 		fp->zero_bytes = aux->zero_bytes;
+		/* 실행 중엔 쓰기가 막혀 있으므로 읽기 전용 페이지는 다른 프로세스와 공유 가능 */
+		fp->shareable = !page->writable;
 	}
 	/* final == VM_ANON 인 경우에는 union을 건드리지 않음. (데이터만 읽어 채움) */
 	
 	/* 2) 파일에서 읽기 */
 	if (aux->read_bytes > 0) {
-		lock_acquire(&fs_lock);
+		rwlock_acquire_read (&fs_lock);
 		int n = file_read_at(aux->file, kva, (int)aux->read_bytes, aux->ofs);
-		lock_release(&fs_lock);
+		rwlock_release_read (&fs_lock);
 		if (n != (int)aux->read_bytes) {	/* 정확히 못 읽으면 실패 */
 			goto done;
 		}
@@ -908,39 +910,14 @@ load_segment (struct file *file, off_t ofs, uint8_t *upage,
 	ASSERT (pg_ofs (upage) == 0);
 	ASSERT (ofs % PGSIZE == 0);
 
-	while (read_bytes > 0 || zero_bytes > 0) {
-		/* 이 페이지를 어떻게 채울지 계산하세요.
-		 * 우리는 FILE에서 PAGE_READ_BYTES 크기의 바이트를 읽어올 것이고, 
-		 * 마지막 PAGE_ZERO_BYTES 크기의 바이트는 0으로 채울 것입니다. */
-		size_t page_read_bytes = read_bytes < PGSIZE ? read_bytes : PGSIZE;
-		size_t page_zero_bytes = PGSIZE - page_read_bytes;
-
-		/* TODO: lazy_load_segment 함수에 정보를 전달하기 위한 보조 데이터(aux)를 설정하세요. */
-
-		/* 페이지별 aux 준비 */
-		struct file_lazy_aux *aux = malloc(sizeof *aux);	
-		if (!aux) return false;
-		aux->file = file;									/* 실행파일은 process.c에서 보관 중인 동일 핸들 */
-		aux->ofs = ofs;										/* 이 페이지의 파일 오프셋 */
-		aux->read_bytes = page_read_bytes;					/* 이번 페이지에서 읽을 크기 */
-		aux->zero_bytes = page_zero_bytes;					/* 이어서 0으로 채울 크기 */
-
-		/* SPT에 "lazy 파일-백드 페이지" 등록만 수행 (실제 로딩은 최초 접근 시 lazy_load_segment에서) */
-		/* 실행 파일의 쓰기 가능 세그먼트는 스왑(개인 사본)이 필요 → VM_ANON
-         * 읽기 전용은 필요 시 파일에서 재로딩하면 되므로 → VM_FILE */
-		enum vm_type pagetype = writable ? VM_ANON : VM_FILE;
-		if (!vm_alloc_page_with_initializer (pagetype, upage, writable, lazy_load_segment, aux)) {
-			free(aux);
-			return false;
-		}
-		
-		/* 다음 페이지로 이동. */
-		read_bytes -= page_read_bytes;
-		zero_bytes -= page_zero_bytes;
-		upage += PGSIZE;
-		ofs += PGSIZE;
-	}
-	return true;
+	/* 세그먼트 전체를 영역 하나로 등록만 함. 페이지별 struct page/aux는
+	 * 첫 폴트 때 영역 정보로 만들어 lazy_load_segment에 넘긴다 (spt_page_from_vma) */
+	/* 실행 파일의 쓰기 가능 세그먼트는 스왑(개인 사본)이 필요 → VM_ANON
+	 * 읽기 전용은 필요 시 파일에서 재로딩하면 되므로 → VM_FILE */
+	enum vm_type pagetype = writable ? VM_ANON : VM_FILE;
+	size_t page_cnt = (read_bytes + zero_bytes) / PGSIZE;
+	return vma_map (&thread_current ()->spt.vmas, upage, page_cnt, pagetype,
+			writable, lazy_load_segment, file, ofs, read_bytes);
 }
 
 static bool
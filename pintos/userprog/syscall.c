@@ -17,22 +17,30 @@
 #include "threads/mmu.h"		// pml4_get_page
 #include "threads/palloc.h" 	// palloc_get_page/palloc_free_page
 
+#include "threads/trace.h"
 #include "threads/init.h"   	// power_off() 선언
 
 #include "filesys/file.h"       // file_close/read/write/seek/tell/length, file_reopen/duplicate
 #include "filesys/filesys.h"	// fs_lock, filesys_*
+#include "devices/disk.h"		// disk_get_stats
+#include "devices/timer.h"		// timer_ticks, timer_ns
+#include "userprog/exception.h"	// exception_get_stats
 #include "devices/input.h"		// input_getc() 
 
 #include "vm/vm.h"
 #include "vm/file.h"
 
-extern struct lock fs_lock;         /* filesys.c의 전역 락을 사용(하나만 써야 함) */
+extern struct rwlock fs_lock;         /* filesys.c의 전역 락을 사용(하나만 써야 함) */
 
 void syscall_entry (void);
 void syscall_handler (struct intr_frame *);
 
 static void *sys_mmap (void *addr, size_t length, int writable, int fd, off_t offset);
 static void  sys_munmap (void *addr);
+#ifdef VM
+static bool  sys_vmstat (struct vm_stats *ust);
+#endif
+static bool  sys_sysstat (struct sys_stats *ust, size_t size);
 
 static void sys_halt (void);
 static tid_t sys_fork (const char *name, struct intr_frame *f);
@@ -100,6 +108,7 @@ syscall_handler (struct intr_frame *f) {
 #endif
 	uint64_t n = f->R.rax;
 
+	TRACE (TRACE_SYSCALL, n, f->R.rdi, f->R.rsi);
 	switch (n) {
 		case SYS_MMAP:
         	f->R.rax = (uint64_t) sys_mmap((void *) f->R.rdi, (size_t) f->R.rsi,
@@ -108,6 +117,18 @@ syscall_handler (struct intr_frame *f) {
     	case SYS_MUNMAP:
 			sys_munmap((void *) f->R.rdi);
 			break;
+#ifdef VM
+		case SYS_VMSTAT:
+			f->R.rax = sys_vmstat ((struct vm_stats *) f->R.rdi);
+			break;
+#endif
+		case SYS_SYSSTAT:
+			f->R.rax = sys_sysstat ((struct sys_stats *) f->R.rdi,
+									(size_t) f->R.rsi);
+			break;
+		case SYS_CLOCK:
+			f->R.rax = timer_ns ();
+			break;
 		case SYS_HALT:
 			sys_halt ();
 			NOT_REACHED ();
@@ -159,6 +180,7 @@ syscall_handler (struct intr_frame *f) {
 		default:
 			sys_exit (-1);
 	}
+	TRACE (TRACE_SYSCALL_DONE, n, f->R.rax, 0);
 }
 
 static void *
@@ -175,6 +197,40 @@ sys_munmap (void *addr) {
 	do_munmap(addr);
 }
 
+#ifdef VM
+/* 현재 프로세스의 VM 통계를 유저 버퍼로 복사 */
+static bool
+sys_vmstat (struct vm_stats *ust) {
+	struct vm_stats st = thread_current ()->spt.stats;	/* 복사 중 폴트로 값이 바뀌지 않게 스냅샷 */
+	copy_out (ust, &st, sizeof st);
+	return true;
+}
+#endif
+
+/* 전역 통계 스냅샷을 유저 버퍼로 복사.
+ * 유저 구조체가 더 작으면(구버전) 앞부분만, 더 크면 아는 만큼만 채운다 */
+static bool
+sys_sysstat (struct sys_stats *ust, size_t size) {
+	struct sys_stats st;
+
+	memset (&st, 0, sizeof st);
+	if (size > sizeof st)
+		size = sizeof st;
+	st.version = SYS_STATS_VERSION;
+	st.size = size;
+	st.ticks = timer_ticks ();
+	thread_get_stats (&st);
+	disk_get_stats (&st);
+	exception_get_stats (&st);
+#ifdef VM
+	vm_get_stats (&st);
+#else
+	st.free_frames = palloc_free_cnt (PAL_USER);
+#endif
+	copy_out (ust, &st, size);
+	return true;
+}
+
 static void 
 sys_halt (void) {
 	power_off();   	/* 절대 돌아오지 않음 */
@@ -185,6 +241,10 @@ void
 sys_exit (int status) {
 	struct thread *cur = thread_current ();
 	printf ("%s: exit(%d)\n", thread_name (), status);
+#ifdef VM
+	if (vmstat_enabled)
+		vm_print_stats (&cur->spt);
+#endif
 
 	/* 부모에게 종료 전달 */
 	if (cur->wstatus) {
@@ -251,9 +311,9 @@ sys_create (const char *file, unsigned initial_size) {
 		return false;
 	}
 
-	lock_acquire(&fs_lock);
+	rwlock_acquire_write (&fs_lock);
 	bool ok = filesys_create(kname, (off_t) initial_size);	/* 실제 생성 요청 */
-	lock_release(&fs_lock);
+	rwlock_release_write (&fs_lock);
 
 	palloc_free_page (kname);			/* 임시 문자열 버퍼 반납 */
 
@@ -271,9 +331,9 @@ sys_remove (const char *file) {
 		return false;
 	}
 
-	lock_acquire(&fs_lock);
+	rwlock_acquire_write (&fs_lock);
 	bool ok = filesys_remove (kname);
-	lock_release(&fs_lock);
+	rwlock_release_write (&fs_lock);
 
 	palloc_free_page (kname);
 
@@ -287,9 +347,9 @@ int sys_open (const char *file) {
 	char *kname = copy_in_string_alloc (file);		/* 유저 문자열을 안전하게 커널 1페이지에 복사(널 포함) */
                                                     /* - 실패 시 내부에서 sys_exit(-1) 호출하므로 여기선 NULL 걱정 X */
 
-	lock_acquire (&fs_lock);
+	rwlock_acquire_write (&fs_lock);
 	struct file *f = filesys_open (kname);
-	lock_release (&fs_lock);
+	rwlock_release_write (&fs_lock);
 
 	palloc_free_page (kname);
 
@@ -297,9 +357,9 @@ int sys_open (const char *file) {
 
 	int fd = fd_install(f);							/* 현재 스레드의 fd 테이블에 파일 객체를 설치하고 새 fd 할당 */
 	if (fd < 0) {									/* 테이블 가득 참 등으로 설치 실패하면 */
-		lock_acquire (&fs_lock);
+		rwlock_acquire_write (&fs_lock);
 		file_close (f);								/* 참조를 해제하고 실제 파일도 닫아 리소스 누수 방지 */
-		lock_release (&fs_lock);
+		rwlock_release_write (&fs_lock);
 		return -1;
 	}
 
@@ -313,9 +373,9 @@ sys_filesize (int fd) {
 	struct file *f = fd_get (fd);
 	if (f == NULL) return -1;
 
-	lock_acquire(&fs_lock);
+	rwlock_acquire_read (&fs_lock);
 	int len = (int) file_length (f); 	/* 파일 길이(바이트) */
-	lock_release(&fs_lock);
+	rwlock_release_read (&fs_lock);
 
 	return len;
 }
@@ -350,9 +410,9 @@ sys_read (int fd, void *buffer, unsigned size) {
 	while (left > 0) {
 		size_t chunk = left > PGSIZE ? PGSIZE : left;	/* 이번에 읽을 크기(최대 1페이지) */
 
-		lock_acquire(&fs_lock);							/* filesys 임계구역 진입 */
+		rwlock_acquire_read (&fs_lock);							/* filesys 임계구역 진입 */
 		int n = file_read(f, kpage, chunk);				/* 파일에서 읽기 */
-		lock_release(&fs_lock);							/* 임계구역 해제 */
+		rwlock_release_read (&fs_lock);							/* 임계구역 해제 */
 
 		if (n < 0) {									/* 오류 */
 			palloc_free_page(kpage);
@@ -418,9 +478,9 @@ sys_write (int fd, const void *buffer, unsigned size) {
 		size_t ask = left > PGSIZE ? PGSIZE : left;			/* 이번에 시도할 쓰기 크기 */
         copy_in(kbuf, buffer, ask);                 
 
-        lock_acquire(&fs_lock);                       
+        rwlock_acquire_write (&fs_lock);                       
         int n = file_write(f, kbuf, ask);            		/* 실제 파일에 쓰기 */
-        lock_release(&fs_lock);                       
+        rwlock_release_write (&fs_lock);                       
 
         if (n < 0) {                                  		/* 쓰기 실패 */
             palloc_free_page(kbuf);
@@ -445,9 +505,9 @@ sys_seek (int fd, unsigned position) {
 	struct file *f = fd_get (fd);
 	if (f == NULL) return;
 
-	lock_acquire(&fs_lock);
+	rwlock_acquire_read (&fs_lock);
     file_seek (f, (off_t) position);      /* 파일 오프셋을 position으로 설정 */
-    lock_release(&fs_lock);
+    rwlock_release_read (&fs_lock);
 }
 
 /* 현재 파일 위치 반환: 잘못된 fd면 (unsigned) -1 반환 */
@@ -460,9 +520,9 @@ sys_tell (int fd) {
 	 */
 	if (f == NULL) return (unsigned) -1;
 
-	lock_acquire(&fs_lock);
+	rwlock_acquire_read (&fs_lock);
 	off_t pos = file_tell (f);			/* 현 오프셋 */
-    lock_release(&fs_lock);
+    rwlock_release_read (&fs_lock);
 
 	return (unsigned) pos;
 }
@@ -486,18 +546,14 @@ copy_in (void *kdst, const void *usrc, size_t n) {
 
 		/* [2] u가 속한 페이지가 현재 프로세스의 페이지테이블에
 		 * '매핑되어 있는지' 확인하고, 커널에서 접근 가능한 커널 가상주소를 얻음. */
-		uint8_t *kva = pml4_get_page(thread_current ()->pml4, (void *)u);
-		if (!kva) {						// 매핑이 없으면 즉시 -1 종료 -> vm에선 vm_try_handle_fault() 호출→한 번 더 pml4_get_page() 시도
-
-			// 2) VM에 페이지 요청(요청 로딩)
+		uint8_t *kva;
+		while ((kva = pml4_get_page(thread_current ()->pml4, (void *)u)) == NULL) {
+			/* 매핑이 없으면 vm_try_handle_fault()로 요청 로딩 후 다시 시도.
+			 * 그 사이 퇴출 배치가 PTE를 또 걷어 갔을 수 있으므로 매핑될 때까지 반복 */
             void *va = (void *) ((uintptr_t)u & ~PGMASK);
             if (!vm_try_handle_fault(NULL, va, true, false, true)) {
                 sys_exit(-1);
             }
-
-			// 3) 다시 시도
-			kva = pml4_get_page(thread_current ()->pml4, (void *)u);
-			if (!kva) sys_exit(-1);
 		}						
 			
 
@@ -532,26 +588,23 @@ copy_out (void *udst, const void *ksrc, size_t n) {
 		if (chunk > n) 
 			chunk = n;
 
-		/* SPT에서 페이지 찾고, 없거나 프레임 없으면 '쓰기 목적'으로 폴트 처리 */
-		struct page *p = spt_find_page(spt, va);
-		if (!p || !p->frame) {
+		/* SPT에서 페이지 찾고, 없거나 프레임 없거나(제로 페이지 포함) PTE가 내려가 있으면
+		 * (퇴출 배치가 쓰는 중) '쓰기 목적'으로 폴트 처리 후 다시 확인 */
+		struct page *p;
+		uint8_t *kva;
+		for (;;) {
+			p = spt_find_page(spt, va);
+			kva = p && p->frame ? pml4_get_page(t->pml4, u) : NULL;
+			if (kva)
+				break;
 			if (!vm_try_handle_fault(NULL, va, true, true, true))
             	sys_exit(-1);
-            
-			p = spt_find_page(spt, va);
-			if (!p || !p->frame) 
-				sys_exit(-1);
 		}
 
 		/* 유저 관점 쓰기 허용 여부 강제 체크 */
 		if (!p->writable)
 			sys_exit(-1);
 
-		/* 커널에서 접근 가능한 주소 얻어 실제 복사 */
-		uint8_t *kva = pml4_get_page(t->pml4, u);
-		if (!kva)
-			sys_exit(-1);
-
 		memcpy(kva, k, chunk);	// [3] 커널 버퍼에서 유저 페이지로 chunk 바이트 복사
 		u += chunk; 
 		k += chunk; 
@@ -578,20 +631,14 @@ copy_in_string_alloc (const char *us) {
 		}
 
 		/* [2] p가 속한 페이지의 커널 접근 주소 */
-		uint8_t *kva = pml4_get_page(thread_current()->pml4, (void *)p);
-		if (!kva) {
-			/* not-present → lazy 로딩 시도 (user=true, write=false) */
+		uint8_t *kva;
+		while ((kva = pml4_get_page(thread_current()->pml4, (void *)p)) == NULL) {
+			/* not-present → lazy 로딩 시도 (user=true, write=false), 매핑될 때까지 반복 */
             void *va = (void *)((uintptr_t)p & ~PGMASK);
             if (!vm_try_handle_fault(NULL, va, true, false, true)) {
                 palloc_free_page(kpage);
                 sys_exit(-1);
             }
-            kva = pml4_get_page(thread_current()->pml4, (void *)p);
-			
-			if (!kva) {
-				palloc_free_page(kpage); 
-				sys_exit(-1);
-			} 
 		}
 
 		size_t off = pg_ofs(p);					// 페이지 내 오프셋
@@ -650,9 +697,9 @@ fd_close(int fd) {
 	struct thread *t = thread_current();
 
 	if (fd >= 2 && fd < FD_MAX && t->fd_table[fd]) {
-		lock_acquire(&fs_lock);
+		rwlock_acquire_write (&fs_lock);
     	file_close(t->fd_table[fd]);	/* 참조 끊기 & 실제 파일 닫기 */
-    	lock_release(&fs_lock);
+    	rwlock_release_write (&fs_lock);
     	t->fd_table[fd] = NULL;			/* 테이블 슬롯 비우기 */
 		
     	if (fd < t->fd_next) { 
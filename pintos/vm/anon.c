@@ -1,25 +1,19 @@
 /* anon.c: Implementation of page for non-disk image (a.k.a. anonymous page). */
 
 #include "vm/vm.h"
-#include "devices/disk.h"
+#include "vm/swap.h"
+#include "vm/zswap.h"
 #include <string.h>
 #include <stdbool.h>
-#include "threads/synch.h"
+#include "threads/trace.h"
 #include "threads/vaddr.h"		// is_user_vaddr, pg_ofs, PGSIZE
-#include "lib/kernel/bitmap.h"
-
-#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)	/* 4096 /512 = 8 */
-
-static struct disk *swap_disk;		/* 스왑 디스크 핸들 */
-static struct bitmap *swap_map;		/* 슬롯 사용 여부 테이블(1슬롯=1페이지) */
-static struct lock swap_lock;		/* swap_map 보호 */
 
 /* 앞으로 쓸, "제로로 채우는" init 콜백(UNINIT.initialize가 호출해줌) */
 bool anon_init_zero (struct page *page, void *aux) {
 	/* vm_do_claim_page()에서 이미 PTE 매핑과 frame 배정이 끝났고,
        지금은 UNINIT.swap_in(=uninit_initialize) 내부에서 불리는 'init' 콜백 단계.
        따라서 page->frame->kva로 바로 쓸 수 있음. */
-	memset(page->frame->kva, 0, PGSIZE);
+	clear_page(page->frame->kva);
 	return true;
 }
 
@@ -40,14 +34,7 @@ static const struct page_operations anon_ops = {
 void
 vm_anon_init (void) {
 	/* TODO: Set up the swap_disk. */
-	swap_disk = disk_get(1, 1);		/* Pintos 기본: chan=1, dev=1 */
-	if (swap_disk == NULL) PANIC("no swap disk");
-
-	size_t slots = disk_size(swap_disk) / SECTORS_PER_PAGE;
-	swap_map = bitmap_create(slots);
-	if (swap_map == NULL) PANIC("no swap bitmap");
-
-	lock_init(&swap_lock);
+	swap_init();		/* 스왑 디스크 + 슬롯 할당기 (vm/swap.c) */
 }
 
 /* 타입 초기화기: ops만 세팅해 타입을 VM_ANON으로 바꿔준다.
@@ -64,38 +51,41 @@ static bool
 anon_swap_in (struct page *page, void *kva) {
 	size_t slot = page->anon.swap_slot;
 	if (slot == SIZE_MAX) {		/* 아직 스왑 간 적 없음 -> 제로필 */
-		memset(kva, 0, PGSIZE);
+		clear_page(kva);
 		return true;
 	}
 
-	for (size_t i = 0; i < SECTORS_PER_PAGE; i++) {
-		disk_read(swap_disk, slot * SECTORS_PER_PAGE + i,
-				  (uint8_t *)kva + i * DISK_SECTOR_SIZE);
+	TRACE (TRACE_SWAP_IN, page->va, slot, 0);
+	page->spt->stats.swap_ins++;
+	if (zswap_load(slot, kva))			/* 압축 풀에 있음: 압축만 풀면 됨 */
+		page->spt->stats.zswap_hits++;
+	else if (swap_cache_take(slot, kva))		/* read-ahead로 이미 읽혀 있음: I/O 없음 */
+		page->spt->stats.swap_cache_hits++;
+	else {
+		swap_read(slot, kva);
+		if (swap_readahead_max > 0)		/* 뒤따르는 이웃 슬롯 미리 읽기 */
+			page->spt->stats.readahead_pages += swap_readahead(slot);
 	}
-
-	lock_acquire(&swap_lock);
-	bitmap_reset(swap_map, slot);		/* 슬롯 회수 */
-	lock_release(&swap_lock);
+	swap_free(slot);		/* 슬롯 회수 */
 
 	page->anon.swap_slot = SIZE_MAX;
 	return true;
 }
 
-/* 스왑아웃: 메모리 페이지를 스왑 슬롯에 기록하고 슬롯 번호를 보관 */
+/* 스왑아웃: 메모리 페이지를 스왑 슬롯(또는 그 슬롯 이름으로 압축 풀)에 기록하고 슬롯 번호를 보관 */
 static bool
 anon_swap_out (struct page *page) {
 	ASSERT(page->frame && page->frame->kva);
 	
-	lock_acquire(&swap_lock);
-	size_t slot = bitmap_scan_and_flip(swap_map, 0, 1, false);
-	lock_release(&swap_lock);
-	if (slot == BITMAP_ERROR) PANIC("swap full");
-
-	uint8_t *kva = page->frame->kva;
-	for (size_t i = 0; i < SECTORS_PER_PAGE; i++) {
-		disk_write(swap_disk, slot * SECTORS_PER_PAGE + i,
-				   kva + i * DISK_SECTOR_SIZE);
-	}
+	/* 같은 프로세스의 페이지는 커서를 따라 연속 슬롯에 놓임 */
+	size_t slot = swap_alloc(&page->spt->swap_cursor);
+	if (slot == SWAP_NONE)
+		return false;		/* 스왑이 꽉 참: 호출자가 다른 희생양을 찾거나 실패 처리 */
+
+	TRACE (TRACE_SWAP_OUT, page->va, slot, 0);
+	page->spt->stats.swap_outs++;
+	if (!zswap_store(slot, page->frame->kva))	/* 압축 풀에 못 넣으면 디스크로 */
+		swap_write(slot, page->frame->kva);
 	page->anon.swap_slot = slot;
 	return true;			/* PTE 해제/연결끊기는 evict에서 */
 }
@@ -103,23 +93,13 @@ anon_swap_out (struct page *page) {
 /* 파괴(destroy) 시 프레임 분리 + 스왑 슬롯 반납 */
 static void
 anon_destroy (struct page *page) {
+    /* 프레임과의 연결을 정리(사용자 매핑 제거 후 프레임을 예비 목록으로 반납).
+     * 진행 중인 퇴출이 슬롯을 새로 잡을 수 있으므로 슬롯 반납보다 먼저 */
+    vm_release_frame(page);
+
 	/* 스왑 슬롯이 남아 있으면 반납 */
     if (page->anon.swap_slot != SIZE_MAX) {
-        lock_acquire(&swap_lock);
-        bitmap_reset(swap_map, page->anon.swap_slot);
-        lock_release(&swap_lock);
+        swap_free(page->anon.swap_slot);
         page->anon.swap_slot = SIZE_MAX;
     }
-
-    /* 프레임과의 연결을 정리(사용자 매핑 제거 후 프레임을 '빈 프레임'으로 만들기) */
-    if (page->frame) {
-        struct frame *fr = page->frame;
-        /* pml4 가 아직 살아있을 때만 안전하게 클리어 */
-        if (fr->pml4 && page->va)
-            pml4_clear_page(fr->pml4, page->va);
-        /* 프레임을 빈 상태로 표시(프레임은 frame_table에 남겨 재사용) */
-        fr->page = NULL;
-        fr->pml4  = NULL;
-        page->frame = NULL;
-    }
 }
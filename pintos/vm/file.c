@@ -15,7 +15,7 @@
 #include "threads/synch.h"
 #include <round.h>				/* ROUND_UP */
 
-extern struct lock fs_lock;
+extern struct rwlock fs_lock;
 
 static bool file_backed_swap_in (struct page *page, void *kva);
 static bool file_backed_swap_out (struct page *page);
@@ -57,13 +57,14 @@ file_lazy_load (struct page *page, void *aux_) {
 	fp->ofs = aux->ofs;
 	fp->read_bytes = aux->read_bytes;
 	fp->zero_bytes = aux->zero_bytes;
+	fp->shareable = false;		/* mmap 파일은 write()로 바뀔 수 있어 공유 안 함 */
 
 	/* 2) 파일에서 읽고 나머지 0 채움 */
 	if (fp->read_bytes > 0) {
-		lock_acquire(&fs_lock);
+		rwlock_acquire_read (&fs_lock);
 		file_seek(fp->file, fp->ofs);
 		int n = file_read(fp->file, kva, (int)fp->read_bytes);
-		lock_release(&fs_lock);
+		rwlock_release_read (&fs_lock);
 
 		if (n != (int)fp->read_bytes) {
 			// free(aux);
@@ -84,9 +85,9 @@ static bool
 file_backed_swap_in (struct page *page, void *kva) {
 	struct file_page *fp = &page->file;
 	if (fp->read_bytes > 0) {
-		lock_acquire(&fs_lock);
+		rwlock_acquire_read (&fs_lock);
 		int n = file_read_at(fp->file, kva, (int)fp->read_bytes, fp->ofs);
-		lock_release(&fs_lock);
+		rwlock_release_read (&fs_lock);
 
 		if (n != (int)fp->read_bytes) return false;
 	}
@@ -103,20 +104,18 @@ static bool
 file_backed_swap_out (struct page *page) {
 	
 	struct frame *fr = page->frame;
-	/* thread_current()->pml4 대신, 프레임 주인의 pml4 사용 */
-	uint64_t *owner_pml4 = fr ? fr->pml4 : thread_current()->pml4;
 
-	/* 하드웨어 dirty 비트로 판단 */
-	if (pml4_is_dirty(owner_pml4, page->va)) {
+	/* 하드웨어 dirty 비트로 판단 (프레임을 매핑한 모든 주소 공간을 rmap으로 확인) */
+	if (vm_frame_is_dirty(fr)) {
 		struct file_page *fp = &page->file;
-		lock_acquire(&fs_lock);
+		rwlock_acquire_write (&fs_lock);
 
 		/* 파일 끝을 넘어서는 부분은 기록하면 안됨 -> read_bytes 만큼만 write-back */
 		/* seek+write  대신 write_at 사용 -> 포지션 공유/실수 차단 */
 		(void)file_write_at(fp->file, fr->kva, (int)fp->read_bytes, fp->ofs);
-		lock_release(&fs_lock);
+		rwlock_release_write (&fs_lock);
 
-		pml4_set_dirty(owner_pml4, page->va, false);
+		vm_frame_clear_dirty(fr);
 	}
 	return true;	/* PTE clear 와 frame 연결해제는 vm_evict_frame()에서 */
 }
@@ -126,19 +125,11 @@ file_backed_swap_out (struct page *page) {
  * (파일 close/write-back은 이미 do_munmap()/region 레벨에서 처리) */
 static void
 file_backed_destroy (struct page *page) {
-	if (page->frame) {
-    	struct frame *fr = page->frame;
-        /* pml4 가 아직 유효할 때만 클리어 (do_munmap 쪽에서 이미 클리어했어도 무해) */
-        if (fr->pml4 && page->va)
-            pml4_clear_page(fr->pml4, page->va);
-        /* 프레임을 빈 상태로 */
-        fr->page = NULL;
-        fr->pml4 = NULL;
-        page->frame = NULL;
-    }
+	/* 프레임을 떼어 예비 목록으로 (do_munmap 쪽에서 이미 뗐으면 무시) */
+	vm_release_frame(page);
 
 	/* 파일 핸들/매핑 정리는 상위에서: 
-     - 실행 파일: process_cleanup()
+     - 페이지가 쓰는 핸들: 영역(vma)이 지워질 때
      - mmap 파일: do_munmap()  */
 }
 
@@ -166,94 +157,34 @@ do_mmap (void *addr, size_t length, int writable,
 
 	/* 페이지 개수 */
 	size_t page_cnt = rounded / PGSIZE;
-	/* 겹침 금지: 매핑될 모든 VA가 비어있는지 확인 */
+	/* 겹침 금지: 다른 영역(실행 파일 세그먼트, 다른 mmap)이나 스택 자리와 겹치면 실패 */
 	struct supplemental_page_table *spt = &thread_current()->spt;
-	for (size_t i = 0; i < page_cnt; i++) {
-		void *va = (uint8_t *)addr + i * PGSIZE;
-		if (spt_find_page(spt, va) != NULL) return NULL;
-	}
+	if (!spt_range_free(spt, addr, (void *)end)) return NULL;
 
-	/* 파일 길이 확인 + region 전용 파일 핸들 준비 */
-	lock_acquire(&fs_lock);
+	/* 파일 길이 확인 (매핑 전용 핸들은 vma_map이 reopen해서 영역이 가짐) */
+	rwlock_acquire_write (&fs_lock);
 	off_t flen = file_length(file);
-	struct file *re = file_reopen(file);
-	lock_release(&fs_lock);
-	if (re == NULL) return NULL;
-	if (flen == 0) {
-		lock_acquire(&fs_lock);
-		file_close(re);
-		lock_release(&fs_lock);
-		return NULL;
-	}
+	rwlock_release_write (&fs_lock);
+	if (flen == 0) return NULL;
 
 	/* region 객체 생성하여 쓰기 */
 	struct mmap_region *region = malloc(sizeof *region);
-	if (!region) {
-		lock_acquire(&fs_lock);
-		file_close(re);
-		lock_release(&fs_lock);
-		return NULL;
-	}
+	if (!region) return NULL;
 	region->start = addr;
 	region->page_cnt = page_cnt;
-	region->file = re;
 	region->writable = (writable != 0);
 
-	/* 페이지별 SPT 등록 (UNINIT + lazy 로더) */
-	size_t remaining = length;
-	off_t ofs = offset;
-
-	for (size_t i = 0; i < page_cnt; i++) {
-		size_t page_read = 0;
-		if (ofs < flen) {
-			/* 파일 내 남은 바이트 범위에서 이 페이지가 읽을 크기 산출 */
-			off_t left_in_file = flen - ofs;
-			page_read = left_in_file < PGSIZE ? (size_t)left_in_file : PGSIZE;
-			if (page_read > remaining) page_read = remaining; 	/* mapping length 상한 */
-		}
-		size_t page_zero = PGSIZE - page_read;
-
-		struct file_lazy_aux *aux = malloc(sizeof *aux);
-		if (!aux) { 	/* 롤백 */
-			for (size_t j = 0; j < i; j++) {
-				void *va = (uint8_t *)addr + j * PGSIZE;
-				struct page *p = spt_find_page(spt, va);
-				if (p) spt_remove_page(spt, p);
-			}
-			lock_acquire(&fs_lock);
-			file_close(re);
-			lock_release(&fs_lock);
-			free(region);
-			return NULL;
-		}
-		*aux = (struct file_lazy_aux){
-			.file = re,
-			.ofs = ofs,
-			.read_bytes = page_read,
-			.zero_bytes = page_zero
-		};
-
-		if (!vm_alloc_page_with_initializer(VM_FILE, (uint8_t *)addr + i * PGSIZE, 
-											region->writable, file_lazy_load, aux)) {
-			free(aux);
-			/* 롤백 (위와 동일) */
-			for (size_t j = 0; j < i; j++) {
-				void *va = (uint8_t *)addr + j * PGSIZE;
-				struct page *p = spt_find_page(spt, va);
-				if (p) spt_remove_page(spt, p);
-			}
-			lock_acquire(&fs_lock);
-			file_close(re);
-			lock_release(&fs_lock);
-			free(region);
-			return NULL;
-		}
-
-		ofs += PGSIZE;
-		if (remaining >= PGSIZE)
-			remaining -= PGSIZE;
-		else
-			remaining = 0;
+	/* 영역 하나로 등록 (페이지는 첫 폴트 때 file_lazy_load로 채움).
+	 * 파일에서 읽을 양은 파일 끝과 mapping length 중 짧은 쪽, 나머지는 0 */
+	size_t file_bytes = 0;
+	if (offset < flen) {
+		file_bytes = (size_t)(flen - offset);
+		if (file_bytes > length) file_bytes = length;
+	}
+	if (!vma_map(&spt->vmas, addr, page_cnt, VM_FILE, region->writable,
+				 file_lazy_load, file, offset, file_bytes)) {
+		free(region);
+		return NULL;
 	}
 
 	/* thread에 region 등록 */
@@ -284,13 +215,18 @@ do_munmap (void *addr) {
 		struct page *p = spt_find_page(&t->spt, va);
 		if (!p) continue;	/* 이미 제거된 경우 */
 
-		/* 프레임이 있고 dirty면 파일로 write-back (read_bytes 만큼만) */
-		if (p->frame && pml4_is_dirty(t->pml4, va)) {
-			struct file_page *fp = &p->file;
-			lock_acquire(&fs_lock);
-			(void) file_write_at(fp->file, p->frame->kva, (int)fp->read_bytes, fp->ofs);
-			lock_release(&fs_lock);
-			pml4_set_dirty(t->pml4, va, false);
+		/* 프레임이 있고 dirty면 파일로 write-back (read_bytes 만큼만).
+		 * 쓰는 동안 page-out 데몬이 프레임을 가져가지 못하게 pin하고, pin한 뒤의 프레임으로 확인 */
+		struct frame *frame = vm_pin_frame(p);
+		if (frame) {
+			if (pml4_is_dirty(t->pml4, va)) {
+				struct file_page *fp = &p->file;
+				rwlock_acquire_write (&fs_lock);
+				(void) file_write_at(fp->file, frame->kva, (int)fp->read_bytes, fp->ofs);
+				rwlock_release_write (&fs_lock);
+				pml4_set_dirty(t->pml4, va, false);
+			}
+			vm_unpin_frame(frame);
 		}
 
 		/* 실제 매핑을 걷고, SPT에서 제거(타입별 destroy 호출 포함) */
@@ -298,20 +234,16 @@ do_munmap (void *addr) {
 
 		/* 프레임이 붙어 있으면 프레임도 고아되지 않게 끊어준다. */
 	    if (p->frame) {
-    		struct frame *fr = p->frame;
-     		fr->page = NULL;
-      		fr->pml4 = NULL;
-      		p->frame = NULL;
+			vm_stat_unresident (p);
+			vm_release_frame (p);
     	}
 
 		spt_remove_page(&t->spt, p);
 	}
+	/* 영역도 지움 (위 페이지들이 쓰던 매핑 전용 파일 핸들이 여기서 닫힘) */
+	vma_unmap(&t->spt.vmas, region->start);
 
-	/* region 마무리: 파일 닫고 리스트에서 제거 */
-	lock_acquire(&fs_lock);
-    file_close(region->file);
-    lock_release(&fs_lock);
-
+	/* region 마무리: 리스트에서 제거 */
     list_remove(&region->elem);
     free(region);
 }
\ No newline at end of file
@@ -0,0 +1,296 @@
+/* swap.c: 스왑 디스크 슬롯 할당과 페이지 단위 입출력. */
+
+#include "vm/swap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <list.h>
+#include <stats.h>
+#include <string.h>
+#include "devices/disk.h"
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/zswap.h"
+
+#define SECTORS_PER_PAGE (PGSIZE / DISK_SECTOR_SIZE)	/* 4096 /512 = 8 */
+#define SWAP_CLUSTER 16			/* 클러스터당 슬롯 수 (64 kB) */
+#define SWAP_CACHE_SIZE 32		/* 스왑 캐시 칸 수 */
+
+/* 클러스터: 사용 중인 슬롯 수가 0이면 free_clusters에 들어 있다 */
+struct swap_cluster {
+	unsigned used;				/* 사용 중인 슬롯 수 */
+	struct list_elem elem;		/* free_clusters 연결용 */
+};
+
+static struct disk *swap_disk;		/* 스왑 디스크 핸들 */
+static struct bitmap *swap_map;		/* 슬롯 사용 여부 테이블(1슬롯=1페이지) */
+static struct lock swap_lock;		/* 아래 상태 전부 보호 */
+
+static struct swap_cluster *clusters;	/* 클러스터 배열 */
+static size_t cluster_cnt;
+static struct list free_clusters;	/* 완전히 빈 클러스터 */
+static size_t slot_cnt;				/* 쓸 수 있는 슬롯 수(클러스터 배수) */
+static size_t used_cnt;				/* 사용 중인 슬롯 수 */
+static size_t scan_hint;			/* 빈 클러스터가 없을 때 쓰는 next-fit 커서 */
+
+/* 스왑 캐시.
+ * 스왑 폴트가 나면 같은 클러스터에 이어서 놓인 슬롯들(대개 같은 프로세스의 이웃 페이지)을
+ * 커널 풀 페이지로 미리 읽어 두고, 그 페이지들의 폴트는 디스크 대신 여기서 복사해 간다.
+ * 슬롯이 반납되면 해당 칸은 무효가 되므로 오래된 내용을 줄 일은 없다. */
+struct swap_cache_entry {
+	size_t slot;				/* 담고 있는 슬롯 (SWAP_NONE이면 빈 칸) */
+	bool ready;					/* 읽기 완료 */
+	bool busy;					/* 디스크에서 읽는 중: 다른 슬롯에 재사용 금지 */
+	void *kva;					/* 내용을 담는 커널 페이지 */
+};
+
+static struct swap_cache_entry swap_cache[SWAP_CACHE_SIZE];
+static size_t cache_hand;			/* 다음에 교체할 칸 (round-robin) */
+
+/* Read-ahead 창: 직전 read-ahead가 절반 이상 적중하면 두 배, 아니면 절반 (1..max) */
+unsigned swap_readahead_max = 8;
+static unsigned ra_window;
+static unsigned ra_issued;			/* 직전 read-ahead로 읽은 페이지 수 */
+static unsigned ra_used;			/* 그중 폴트에서 쓰인 수 */
+
+/* 스왑 디스크(hd1:1)를 찾고 클러스터 테이블을 만든다 */
+void
+swap_init (void) {
+	swap_disk = disk_get (1, 1);		/* Pintos 기본: chan=1, dev=1 */
+	if (swap_disk == NULL) PANIC ("no swap disk");
+
+	/* 클러스터에 못 미치는 끝자락 슬롯은 쓰지 않음 */
+	cluster_cnt = disk_size (swap_disk) / SECTORS_PER_PAGE / SWAP_CLUSTER;
+	slot_cnt = cluster_cnt * SWAP_CLUSTER;
+	swap_map = bitmap_create (slot_cnt);
+	clusters = calloc (cluster_cnt ? cluster_cnt : 1, sizeof *clusters);
+	if (swap_map == NULL || clusters == NULL) PANIC ("no swap bitmap");
+
+	list_init (&free_clusters);
+	for (size_t i = 0; i < cluster_cnt; i++)
+		list_push_back (&free_clusters, &clusters[i].elem);
+
+	for (size_t i = 0; i < SWAP_CACHE_SIZE; i++) {
+		swap_cache[i].slot = SWAP_NONE;
+		swap_cache[i].kva = palloc_get_page (PAL_ASSERT);
+	}
+	ra_window = swap_readahead_max;
+
+	lock_init (&swap_lock);
+	lock_set_name (&swap_lock, "swap_lock");
+	zswap_init (slot_cnt);
+}
+
+/* SLOT을 담은 캐시 칸. swap_lock을 잡은 채로 호출 */
+static struct swap_cache_entry *
+cache_lookup (size_t slot) {
+	for (size_t i = 0; i < SWAP_CACHE_SIZE; i++)
+		if (swap_cache[i].slot == slot)
+			return &swap_cache[i];
+	return NULL;
+}
+
+/* 새 슬롯에 쓸 캐시 칸을 고름(읽는 중인 칸은 건너뜀). 없으면 NULL.
+ * swap_lock을 잡은 채로 호출 */
+static struct swap_cache_entry *
+cache_victim (void) {
+	for (size_t n = 0; n < SWAP_CACHE_SIZE; n++) {
+		struct swap_cache_entry *e = &swap_cache[cache_hand];
+		cache_hand = (cache_hand + 1) % SWAP_CACHE_SIZE;
+		if (!e->busy)
+			return e;
+	}
+	return NULL;
+}
+
+void
+swap_cursor_init (struct swap_cursor *cur) {
+	cur->next = cur->end = SWAP_NONE;
+}
+
+/* SLOT을 사용 중으로 표시. swap_lock을 잡은 채로 호출 */
+static void
+slot_take (size_t slot) {
+	struct swap_cluster *c = &clusters[slot / SWAP_CLUSTER];
+
+	bitmap_mark (swap_map, slot);
+	used_cnt++;
+	if (c->used++ == 0)
+		list_remove (&c->elem);		/* 더 이상 빈 클러스터가 아님 */
+}
+
+/* 빈 슬롯 하나를 잡아 번호를 리턴. 스왑이 꽉 차면 SWAP_NONE.
+ * 1) 커서의 클러스터 안에서 다음 슬롯
+ * 2) 빈 클러스터를 하나 받아 커서를 옮김
+ * 3) 그래도 없으면 전역 next-fit으로 아무 구멍 */
+size_t
+swap_alloc (struct swap_cursor *cur) {
+	size_t slot = SWAP_NONE;
+
+	lock_acquire (&swap_lock);
+	while (cur->next < cur->end) {
+		size_t s = cur->next++;
+		if (!bitmap_test (swap_map, s)) {
+			slot = s;
+			break;
+		}
+	}
+
+	if (slot == SWAP_NONE && !list_empty (&free_clusters)) {
+		struct swap_cluster *c = list_entry (list_front (&free_clusters),
+				struct swap_cluster, elem);
+		slot = (size_t) (c - clusters) * SWAP_CLUSTER;
+		cur->next = slot + 1;
+		cur->end = slot + SWAP_CLUSTER;
+	}
+
+	if (slot == SWAP_NONE && used_cnt < slot_cnt) {
+		slot = bitmap_scan (swap_map, scan_hint, 1, false);
+		if (slot == BITMAP_ERROR)
+			slot = bitmap_scan (swap_map, 0, 1, false);
+		ASSERT (slot != BITMAP_ERROR);
+		scan_hint = slot + 1 < slot_cnt ? slot + 1 : 0;
+	}
+
+	if (slot != SWAP_NONE)
+		slot_take (slot);
+	lock_release (&swap_lock);
+	return slot;
+}
+
+/* SLOT을 반납 */
+void
+swap_free (size_t slot) {
+	zswap_invalidate (slot);		/* 압축 풀에 있으면 버림 (swap_lock보다 먼저) */
+	lock_acquire (&swap_lock);
+	ASSERT (slot < slot_cnt && bitmap_test (swap_map, slot));
+	bitmap_reset (swap_map, slot);
+	used_cnt--;
+	struct swap_cache_entry *e = cache_lookup (slot);
+	if (e != NULL)
+		e->slot = SWAP_NONE;		/* 슬롯 내용이 더 이상 유효하지 않음 */
+	struct swap_cluster *c = &clusters[slot / SWAP_CLUSTER];
+	if (--c->used == 0)
+		list_push_back (&free_clusters, &c->elem);
+	lock_release (&swap_lock);
+}
+
+/* SLOT의 페이지를 KVA로 읽음 (슬롯은 그대로 유지) */
+void
+swap_read (size_t slot, void *kva) {
+	for (size_t i = 0; i < SECTORS_PER_PAGE; i++)
+		disk_read (swap_disk, slot * SECTORS_PER_PAGE + i,
+				   (uint8_t *) kva + i * DISK_SECTOR_SIZE);
+}
+
+/* KVA의 페이지를 SLOT에 기록.
+ * 그 전에 read-ahead가 같은 슬롯의 옛 내용을 읽어 두었을 수 있으므로 캐시 칸을 무효화 */
+void
+swap_write (size_t slot, const void *kva) {
+	for (size_t i = 0; i < SECTORS_PER_PAGE; i++)
+		disk_write (swap_disk, slot * SECTORS_PER_PAGE + i,
+					(const uint8_t *) kva + i * DISK_SECTOR_SIZE);
+
+	lock_acquire (&swap_lock);
+	struct swap_cache_entry *e = cache_lookup (slot);
+	if (e != NULL)
+		e->slot = SWAP_NONE;
+	lock_release (&swap_lock);
+}
+
+/* SLOT이 스왑 캐시에 있으면 KVA로 복사하고 칸을 비운 뒤 true (디스크 I/O 없음) */
+bool
+swap_cache_take (size_t slot, void *kva) {
+	bool hit = false;
+
+	lock_acquire (&swap_lock);
+	struct swap_cache_entry *e = cache_lookup (slot);
+	if (e != NULL && e->ready) {
+		memcpy (kva, e->kva, PGSIZE);
+		e->slot = SWAP_NONE;
+		ra_used++;
+		hit = true;
+	}
+	lock_release (&swap_lock);
+	return hit;
+}
+
+/* SLOT이 읽기 완료된 채로 캐시에 있는지 (major/minor 폴트 구분용) */
+bool
+swap_cached (size_t slot) {
+	lock_acquire (&swap_lock);
+	struct swap_cache_entry *e = cache_lookup (slot);
+	bool cached = e != NULL && e->ready;
+	lock_release (&swap_lock);
+	return cached;
+}
+
+/* SLOT 뒤로 연속해서 사용 중인 슬롯들을 스왑 캐시로 미리 읽고, 읽은 페이지 수를 리턴.
+ * 클러스터 경계나 빈 슬롯에서 멈추고, 압축 풀에 있는 슬롯은 건너뛴다. 창 크기는 직전 read-ahead의 적중률로 조절 */
+size_t
+swap_readahead (size_t slot) {
+	struct swap_cache_entry *targets[SWAP_CACHE_SIZE];
+	size_t slots[SWAP_CACHE_SIZE];
+	size_t n = 0;
+
+	lock_acquire (&swap_lock);
+	if (ra_issued > 0) {
+		if (ra_used * 2 >= ra_issued)
+			ra_window *= 2;
+		else
+			ra_window /= 2;
+	}
+	if (ra_window < 1)
+		ra_window = 1;
+	if (ra_window > swap_readahead_max)
+		ra_window = swap_readahead_max;
+	if (ra_window > SWAP_CACHE_SIZE / 2)
+		ra_window = SWAP_CACHE_SIZE / 2;
+
+	size_t end = (slot / SWAP_CLUSTER + 1) * SWAP_CLUSTER;
+	for (size_t s = slot + 1; s < end && n < ra_window; s++) {
+		if (!bitmap_test (swap_map, s))
+			break;
+		if (cache_lookup (s) != NULL || zswap_contains (s))
+			continue;		/* 이미 메모리에 있음 */
+		struct swap_cache_entry *e = cache_victim ();
+		if (e == NULL)
+			break;
+		e->slot = s;
+		e->ready = false;
+		e->busy = true;
+		targets[n] = e;
+		slots[n++] = s;
+	}
+	ra_issued = n;
+	ra_used = 0;
+	lock_release (&swap_lock);
+
+	/* 디스크 I/O는 락 밖에서. 그 사이 슬롯이 반납되면 칸의 slot이 SWAP_NONE이 된다 */
+	for (size_t i = 0; i < n; i++)
+		swap_read (slots[i], targets[i]->kva);
+
+	lock_acquire (&swap_lock);
+	for (size_t i = 0; i < n; i++) {
+		targets[i]->busy = false;
+		targets[i]->ready = targets[i]->slot == slots[i];
+	}
+	lock_release (&swap_lock);
+	return n;
+}
+
+/* 빈 슬롯이 남아 있는지 (퇴출 대상 고를 때 힌트, 락 없이 읽음) */
+bool
+swap_available (void) {
+	return used_cnt < slot_cnt;
+}
+
+/* 스왑 슬롯 사용량을 ST에 기록 */
+void
+swap_get_stats (struct sys_stats *st) {
+	lock_acquire (&swap_lock);
+	st->swap_slots_used = used_cnt;
+	st->swap_slots = slot_cnt;
+	lock_release (&swap_lock);
+}
@@ -13,7 +13,7 @@
 #include "userprog/process.h" /* struct file_lazy_aux */
 #include "filesys/file.h"
 
-extern struct lock fs_lock;
+extern struct rwlock fs_lock;
 
 static bool uninit_initialize (struct page *page, void *kva);
 static void uninit_destroy (struct page *page);
@@ -10,19 +10,75 @@
 #include "threads/thread.h"          // thread_current
 #include <string.h>                  // memset, memcpy
 #include <debug.h>                   // ASSERT
+#include <inttypes.h>                // PRIu64
+#include <stdio.h>                   // printf
+#include <stdlib.h>                  // qsort
 
 #include "userprog/process.h" 		/* file_lazy_aux */
 
 #include "lib/kernel/list.h"
 #include "threads/synch.h"
+#include "threads/trace.h"
 
 #include "devices/disk.h"
 #include "filesys/file.h"
 
-static struct list frame_table; 	/* 모든 유저 프레임 */
-static struct lock frame_lock;		/* frame_table 보호 */
-
-extern struct lock fs_lock;
+static struct list frame_table; 	/* 페이지를 담고 있는 유저 프레임 (퇴출 후보) */
+static struct lock frame_lock;		/* frame_table, 프레임<->페이지 연결 보호 */
+static struct condition evict_cond;	/* 퇴출 배치가 끝남 (frame_lock과 함께 씀) */
+static uint64_t evict_cnt;			/* 전체 퇴출 횟수 (sysstat) */
+
+/* 빈 프레임 예비 목록과 page-out 데몬.
+ * 유저 풀이 바닥난 뒤에는 폴트가 예비 목록에서 바로 프레임을 가져가고,
+ * 예비가 RESERVE_LOW 아래로 내려가면 데몬이 깨어나 RESERVE_HIGH까지
+ * 미리 퇴출(스왑 쓰기 포함)해 채워둔다. 예비가 비었을 때만 폴트 스레드가 직접 퇴출.
+ * 묶음의 디스크 쓰기는 frame_lock을 놓고 하며, 그동안 희생 프레임은 evicting 표시로 보호된다:
+ * 그 프레임의 페이지를 건드리려는 쪽만 evict_cond에서 기다리고, 나머지 폴트는 그대로 진행.
+ * 예비 목록은 reserve_lock이 따로 보호한다. 락 순서: frame_lock -> reserve_lock */
+#define RESERVE_LOW 8
+#define RESERVE_HIGH 32
+#define EVICT_BATCH 16				/* 데몬이 한 번에 내보내는 최대 프레임 수 */
+
+static struct lock reserve_lock;	/* 아래 예비 목록/데몬 상태 보호 */
+static struct list frame_reserve;	/* 비어 있는 프레임 */
+static size_t reserve_cnt;			/* frame_reserve 길이 */
+static bool user_pool_empty;		/* palloc(PAL_USER)가 한 번이라도 실패했나 */
+static bool pageout_pending;		/* 데몬을 이미 깨웠나 */
+static struct semaphore pageout_sema;	/* 데몬 깨우기 */
+static void pageout_daemon (void *aux);
+
+/* 실행 파일 읽기 전용 페이지 공유.
+ * 같은 실행 파일의 같은 위치(inode, ofs, read_bytes)를 읽는 읽기 전용 페이지는 프레임 하나를
+ * 여러 주소 공간이 함께 매핑한다. 항목은 프레임이 처음 채워질 때 만들어지고, 마지막 매핑이
+ * 사라지거나 프레임이 퇴출되면 없어진다. 실행 중인 파일은 쓰기가 막혀 있으므로 내용이 바뀌지 않는다.
+ * 프레임을 매핑한 페이지들은 프레임의 rmap에 있다. share_table은 frame_lock이 보호 */
+struct share {
+	struct inode *inode;		/* 키: 실행 파일 */
+	off_t ofs;					/* 키: 파일 오프셋 */
+	size_t read_bytes;			/* 키: 읽는 바이트 수 (나머지는 0) */
+	struct frame *frame;		/* 공유 프레임 */
+	struct hash_elem elem;		/* share_table 연결 */
+};
+
+static struct hash share_table;
+
+/* 공유 제로 페이지: 아직 쓰인 적 없는 익명 페이지의 읽기 폴트는 프레임 대신
+ * 이 페이지를 읽기 전용으로 매핑하고, 첫 쓰기 폴트(vm_handle_wp)에서 개인 프레임을 받는다.
+ * 커널 풀에서 할당하므로 유저 풀 프레임을 쓰지 않고, 퇴출/스왑 대상도 아니다.
+ * CR0.WP가 꺼져 있어 커널의 쓰기는 막히지 않으므로, 커널이 유저 페이지에 쓸 때는
+ * 반드시 copy_out()처럼 page->frame을 확인해 폴트를 먼저 처리해야 한다. */
+static void *zero_kva;
+
+extern struct rwlock fs_lock;
+
+/* -vmstat: 종료하는 프로세스마다 VM 통계 한 줄 출력 */
+bool vmstat_enabled;
+
+/* Fault-around: 파일에서 읽어야 하는 폴트가 나면 뒤따르는 아직 안 들인 파일 페이지들을
+ * 같은 폴트 안에서 함께 읽어 매핑한다. 창은 FAULT_AROUND_INIT에서 시작해
+ * 순차 접근이면 두 배, 아니면 절반 (최대 fault_around_max) */
+#define FAULT_AROUND_INIT 4
+unsigned fault_around_max = 16;
 
 /* ---------- SPT 해시용 보조 함수들 ---------- */
 
@@ -45,6 +101,27 @@ page_less (const struct hash_elem *a,
 	return pa->va < pb->va;
 }
 
+/* 공유 항목 키: (inode, ofs, read_bytes) */
+static uint64_t
+share_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct share *sh = hash_entry (e, struct share, elem);
+	uint64_t h = hash_bytes (&sh->inode, sizeof sh->inode);
+	h ^= hash_bytes (&sh->ofs, sizeof sh->ofs);
+	return h ^ hash_bytes (&sh->read_bytes, sizeof sh->read_bytes);
+}
+
+static bool
+share_less (const struct hash_elem *a_, const struct hash_elem *b_,
+			void *aux UNUSED) {
+	const struct share *a = hash_entry (a_, struct share, elem);
+	const struct share *b = hash_entry (b_, struct share, elem);
+	if (a->inode != b->inode)
+		return a->inode < b->inode;
+	if (a->ofs != b->ofs)
+		return a->ofs < b->ofs;
+	return a->read_bytes < b->read_bytes;
+}
+
 /* ---------- VM 서브 시스템 초기화 ---------- */
 
 /* Initializes the virtual memory subsystem by invoking each subsystem's
@@ -55,7 +132,16 @@ vm_init (void) {
 	vm_file_init ();	/* 파일 페이지 ops 등록 */
 
 	list_init(&frame_table);
+	list_init(&frame_reserve);
 	lock_init(&frame_lock);
+	lock_set_name (&frame_lock, "frame_lock");
+	cond_init (&evict_cond);
+	lock_init (&reserve_lock);
+	lock_set_name (&reserve_lock, "frame_reserve");
+	hash_init (&share_table, share_hash, share_less, NULL);
+	sema_init (&pageout_sema, 0);
+	thread_create ("pageout", PRI_DEFAULT, pageout_daemon, NULL);
+	zero_kva = palloc_get_page (PAL_ASSERT | PAL_ZERO);
 
 #ifdef EFILESYS  /* For project 4 */
 	pagecache_init ();
@@ -84,7 +170,12 @@ page_get_type (struct page *page) {
 /* Helpers */
 static struct frame *vm_get_victim (void);
 static bool vm_do_claim_page (struct page *page);
+static bool vm_claim_shared (struct page *page, struct share *key);
 static struct frame *vm_evict_frame (void);
+static bool spt_copy_pages (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src);
+static void vm_unmap_zero_page (struct page *page);
+static bool page_is_untouched_zero (struct page *page);
 
 /* ---------- 페이지 등록 (예약) ---------- */
 bool
@@ -121,7 +212,6 @@ vm_alloc_page_with_initializer (enum vm_type type, void *upage, bool writable,
 		page_initializer = anon_initializer;
 		/* 익명 페이지의 기본 내용은 제로필: init 콜백이 NULL이라면 기본 제로필로 대체 */
 		if (init == NULL) {
-			extern bool anon_init_zero (struct page *page, void *aux);
 			init = anon_init_zero;
 			aux = NULL;
 		}
@@ -161,7 +251,10 @@ spt_find_page (struct supplemental_page_table *spt, void *va) {
 	struct page key;					/* 조회용 임시 키(page) 객체를 스택에 만들고, 같은 키(h_elem)를 가진걸 찾는다.*/
 	key.va = pg_round_down (va);		/* 키는 페이지 경계 기준 */
 
+	/* 조회끼리는 동시에 진행 가능 */
+	rwlock_acquire_read (&spt->lock);
 	struct hash_elem *e = hash_find (&spt->pages, &key.h_elem);
+	rwlock_release_read (&spt->lock);
 	if (e == NULL) return NULL;
 
 	return hash_entry (e, struct page, h_elem);
@@ -170,14 +263,22 @@ spt_find_page (struct supplemental_page_table *spt, void *va) {
 /* PAGE를 SPT에 삽입 */
 bool
 spt_insert_page (struct supplemental_page_table *spt, struct page *page) {
+	page->spt = spt;
+	rwlock_acquire_write (&spt->lock);
 	struct hash_elem *old = hash_insert (&spt->pages, &page->h_elem);
+	rwlock_release_write (&spt->lock);
 	return old == NULL;		/* 기존에 없었으면 성공 */
 }
 
 void
 spt_remove_page (struct supplemental_page_table *spt, struct page *page) {
 	/* 해시에서 먼저 빼고, 그 다음 page 파괴 */
+	rwlock_acquire_write (&spt->lock);
 	hash_delete (&spt->pages, &page->h_elem);
+	rwlock_release_write (&spt->lock);
+	if (page->frame)
+		vm_stat_unresident (page);
+	vm_unmap_zero_page (page);
 	vm_dealloc_page (page);
 }
 
@@ -196,90 +297,424 @@ vm_get_victim (void) {
 	return victim;
 }
 
-/* Evict one page and return the corresponding frame.
- * Return NULL on error.*/
-static struct frame *
-vm_evict_frame (void) {
-	/* victim을 swap_out하고 프레임 반환 */
-	
-	/* 아주 단순한 second-chance */
-	lock_acquire(&frame_lock);
-	ASSERT(!list_empty(&frame_table));
+/* ---------- 실행 파일 페이지 공유 ---------- */
 
-	struct frame *victim = NULL;
+/* PAGE가 공유 대상이면 키를 KEY에 채우고 true.
+ * lazy 로드 전(UNINIT)이면 aux에서, 이미 파일 페이지면 file_page에서 가져옴 */
+static bool
+share_key (struct page *page, struct share *key) {
+	struct file *file;
+
+	if (page->writable)
+		return false;
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_UNINIT: {
+			struct file_lazy_aux *aux = page->uninit.aux;
+			if (page->uninit.init != lazy_load_segment
+					|| VM_TYPE (page->uninit.type) != VM_FILE)
+				return false;
+			file = aux->file;
+			key->ofs = aux->ofs;
+			key->read_bytes = aux->read_bytes;
+			break;
+		}
+		case VM_FILE:
+			if (!page->file.shareable)
+				return false;
+			file = page->file.file;
+			key->ofs = page->file.ofs;
+			key->read_bytes = page->file.read_bytes;
+			break;
+		default:
+			return false;
+	}
+	key->inode = file_get_inode (file);
+	return true;
+}
 
-	/* 한 바퀴 돌며 accessed=0 인 것 선택, 있으면 그걸, 없으면 첫 번째 */
-	for (int pass = 0; pass < 2 && victim == NULL; pass++) {
-		for (struct list_elem *e = list_begin(&frame_table); 
-			 e != list_end(&frame_table); e = list_next(e)) {
+/* KEY의 공유 항목. frame_lock을 잡은 채로 호출 */
+static struct share *
+share_lookup (struct share *key) {
+	struct hash_elem *e = hash_find (&share_table, &key->elem);
+	return e != NULL ? hash_entry (e, struct share, elem) : NULL;
+}
 
-			struct frame *f = list_entry(e, struct frame, elem);
-			if (f->page == NULL) {	/* 이미 비어있으면 재사용 */
-				victim = f;
-				break;
-			}
+/* PAGE의 내용이 이미 공유 프레임에 있는지 (major/minor 구분용) */
+static bool
+share_cached (struct page *page) {
+	struct share key;
+	if (!share_key (page, &key))
+		return false;
+	lock_acquire (&frame_lock);
+	bool cached = share_lookup (&key) != NULL;
+	lock_release (&frame_lock);
+	return cached;
+}
+
+/* 방금 PAGE 내용으로 채운 FRAME을 KEY로 공유 목록에 올림.
+ * 그 사이 다른 프로세스가 같은 키를 올렸거나 메모리가 없으면 그냥 개인 프레임으로 둠.
+ * frame_lock을 잡은 채로 호출 */
+static void
+share_publish (struct share *key, struct frame *frame) {
+	if (share_lookup (key) != NULL)
+		return;
+	struct share *sh = malloc (sizeof *sh);
+	if (sh == NULL)
+		return;
+	*sh = *key;
+	sh->frame = frame;
+	hash_insert (&share_table, &sh->elem);
+	frame->share = sh;
+}
+
+/* FRAME이 공유 중이면 항목을 없앰 (마지막 매핑이 사라졌거나 퇴출될 때).
+ * frame_lock을 잡은 채로 호출 */
+static void
+share_drop (struct frame *frame) {
+	struct share *sh = frame->share;
+	if (sh == NULL)
+		return;
+	hash_delete (&share_table, &sh->elem);
+	free (sh);
+	frame->share = NULL;
+}
+
+/* ---------- 역방향 매핑 (rmap) ----------
+ * 프레임마다 그 프레임을 매핑한 페이지 목록을 둔다. 페이지가 자기 (pml4, va)를 알고 있어
+ * 항목은 struct page 안의 list_elem 하나로 충분하고 따로 할당하지 않는다.
+ * 개인 프레임은 항목이 하나, 공유 프레임은 매핑한 프로세스 수만큼.
+ * 프레임이 frame_table에 들어간 뒤에는 frame_lock 아래에서만 바꾼다 */
+
+/* FRAME에 현재 주소 공간의 PAGE 매핑을 추가 (PTE 설치는 호출자가) */
+static void
+rmap_add (struct frame *frame, struct page *page) {
+	page->frame = frame;
+	page->pml4 = thread_current ()->pml4;
+	list_push_back (&frame->rmap, &page->rmap_elem);
+}
+
+/* PAGE의 PTE를 걷고 프레임의 rmap에서 뺌. 프레임에 매핑이 하나도 안 남으면 true */
+static bool
+rmap_remove (struct page *page) {
+	struct frame *frame = page->frame;
+
+	pml4_clear_page (page->pml4, page->va);
+	list_remove (&page->rmap_elem);
+	page->frame = NULL;
+	return list_empty (&frame->rmap);
+}
+
+/* FRAME을 처음 매핑한 페이지 (퇴출 시 백스토어 I/O를 맡을 페이지) */
+static struct page *
+rmap_first (struct frame *frame) {
+	if (list_empty (&frame->rmap))
+		return NULL;
+	return list_entry (list_front (&frame->rmap), struct page, rmap_elem);
+}
+
+/* FRAME을 매핑한 쪽 중 하나라도 접근했는지. 접근 비트는 모두 지움 (second-chance) */
+static bool
+rmap_test_and_clear_accessed (struct frame *frame) {
+	bool accessed = false;
+	for (struct list_elem *e = list_begin (&frame->rmap); e != list_end (&frame->rmap);
+		 e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, rmap_elem);
+		if (pml4_is_accessed (p->pml4, p->va)) {
+			pml4_set_accessed (p->pml4, p->va, false);
+			accessed = true;
+		}
+	}
+	return accessed;
+}
+
+/* FRAME을 매핑한 쪽 중 하나라도 썼는지 */
+bool
+vm_frame_is_dirty (struct frame *frame) {
+	for (struct list_elem *e = list_begin (&frame->rmap); e != list_end (&frame->rmap);
+		 e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, rmap_elem);
+		if (pml4_is_dirty (p->pml4, p->va))
+			return true;
+	}
+	return false;
+}
+
+/* FRAME의 모든 매핑에서 dirty 비트를 지움 (write-back 직후) */
+void
+vm_frame_clear_dirty (struct frame *frame) {
+	for (struct list_elem *e = list_begin (&frame->rmap); e != list_end (&frame->rmap);
+		 e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, rmap_elem);
+		pml4_set_dirty (p->pml4, p->va, false);
+	}
+}
+
+/* 퇴출 준비: FRAME의 모든 PTE에서 present만 내림 (rmap 연결과 dirty 비트는 그대로).
+ * 이후 유저 접근은 폴트가 되어 handle_fault 입구에서 퇴출이 끝나길 기다린다 */
+static void
+rmap_clear_ptes (struct frame *frame) {
+	for (struct list_elem *e = list_begin (&frame->rmap); e != list_end (&frame->rmap);
+		 e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, rmap_elem);
+		pml4_clear_page (p->pml4, p->va);
+	}
+}
+
+/* 내보내기에 실패한 FRAME의 PTE를 되살림. pml4_set_page()가 dirty를 지우므로 다시 세움 */
+static void
+rmap_restore_ptes (struct frame *frame) {
+	for (struct list_elem *e = list_begin (&frame->rmap); e != list_end (&frame->rmap);
+		 e = list_next (e)) {
+		struct page *p = list_entry (e, struct page, rmap_elem);
+		bool dirty = pml4_is_dirty (p->pml4, p->va);
+		bool writable = p->writable && frame->share == NULL;
+		if (pml4_set_page (p->pml4, p->va, frame->kva, writable))
+			pml4_set_dirty (p->pml4, p->va, dirty);
+	}
+}
+
+/* 퇴출: FRAME의 모든 매핑을 걷음. 페이지들은 다음 폴트 때 백스토어에서 다시 들어온다 */
+static void
+rmap_unmap_all (struct frame *frame) {
+	struct page *p;
+	while ((p = rmap_first (frame)) != NULL) {
+		TRACE (TRACE_EVICT, frame->kva, p->va, 0);
+		p->spt->stats.evictions++;
+		vm_stat_unresident (p);
+		rmap_remove (p);
+	}
+}
 
-			bool acc = pml4_is_accessed(f->pml4, f->page->va);
-			if (pass == 0 && acc) {
-				pml4_set_accessed(f->pml4, f->page->va, false);
+/* 희생 프레임을 최대 MAX개 골라 frame_table에서 빼고 VICTIMS에 담음 (second-chance).
+ * 첫 바퀴는 accessed=0 인 것만 고르며 나머지의 accessed를 지우고,
+ * 모자라면 둘째 바퀴에서 남은 후보를 앞에서부터 채움. frame_lock을 잡은 채로 호출 */
+static size_t
+vm_pick_victims (struct frame **victims, size_t max) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	size_t cnt = 0;
+	/* 스왑이 꽉 찼으면 익명 페이지는 내보낼 곳이 없으니 건너뜀 */
+	bool can_swap = swap_available();
+
+	for (int pass = 0; pass < 2 && cnt < max; pass++) {
+		struct list_elem *e = list_begin(&frame_table);
+		while (e != list_end(&frame_table) && cnt < max) {
+			struct frame *f = list_entry(e, struct frame, elem);
+			struct page *p = rmap_first(f);
+			if (f->pinned) {		/* fork가 복사 중인 프레임 */
+				e = list_next(e);
 				continue;
 			}
-			victim = f;
-			break;
+			if (p != NULL) {
+				if (!can_swap && page_get_type(p) == VM_ANON) {
+					e = list_next(e);
+					continue;
+				}
+				/* 매핑한 쪽 중 하나라도 접근했으면 기회를 한 번 더 */
+				if (pass == 0 && rmap_test_and_clear_accessed(f)) {
+					e = list_next(e);
+					continue;
+				}
+			}
+			e = list_remove(e);		/* 이미 비어있는 프레임도 그대로 재사용 */
+			victims[cnt++] = f;
 		}
 	}
-	ASSERT(victim != NULL);
+	return cnt;
+}
 
-	struct page *p = victim->page;
-	/* 이미 비어있는 프레임은 디스크 I/O 없이 즉시 재사용 
-	 * (NULL 페이지에 대해 swap_out 금지) */
-	if (p == NULL) {
-		victim->pml4 = NULL;
-		lock_release(&frame_lock);
-		return victim;
+/* 희생 프레임 정렬 기준: 같은 프로세스끼리, 그 안에서는 VA 오름차순.
+ * 익명 페이지는 프로세스별 스왑 커서에서 차례로 슬롯을 받으므로
+ * 이 순서로 내보내면 한 프로세스의 페이지가 연속 슬롯에 오름차순으로 기록된다 */
+static int
+victim_cmp (const void *a_, const void *b_) {
+	const struct page *a = rmap_first (*(struct frame *const *) a_);
+	const struct page *b = rmap_first (*(struct frame *const *) b_);
+	if (a == NULL || b == NULL)
+		return (a != NULL) - (b != NULL);
+	if (a->spt != b->spt)
+		return a->spt < b->spt ? -1 : 1;
+	return a->va < b->va ? -1 : a->va > b->va;
+}
+
+/* 희생 프레임을 최대 MAX개 골라 한 번에 내보내고, 비운 프레임을 VICTIMS 앞쪽에 담아 개수 리턴.
+ * frame_lock 아래에서 고르고 매핑을 걷어 evicting으로 표시한 뒤, 락을 놓고 정렬된 순서로 쓴다.
+ * 쓰는 동안 그 페이지에 폴트하거나 프레임을 떼려는 쪽은 evict_cond에서 기다림.
+ * 내보내기에 실패한 프레임(그 사이 스왑이 꽉 참)은 매핑을 되살려 frame_table로 되돌림 */
+static size_t
+vm_evict_batch (struct frame **victims, size_t max) {
+	struct page *pages[max];
+	bool ok[max];
+
+	lock_acquire(&frame_lock);
+	size_t cnt = vm_pick_victims(victims, max);
+	if (cnt > 1)
+		qsort(victims, cnt, sizeof *victims, victim_cmp);
+
+	/* 쓰기 전에 배치 전체의 매핑부터 걷음: 내보내는 도중 주인이 쓴 내용이
+	 * 스왑/파일 사본에서 빠지지 않도록 (데몬은 유저 프로세스와 동시에 돈다) */
+	for (size_t i = 0; i < cnt; i++) {
+		victims[i]->evicting = true;
+		rmap_clear_ptes(victims[i]);
+		pages[i] = rmap_first(victims[i]);
 	}
+	lock_release(&frame_lock);
 
-	/* 타입별 백스토어로 밀어내기*/
-	bool ok = swap_out(p);		/* == p->operations->swap_out(p) */
-	ASSERT(ok);
+	/* 타입별 백스토어로 밀어내기 (락 없이). evicting이 rmap과 페이지 수명을 지켜줌.
+	 * 이미 비어있는 프레임(NULL 페이지)과 공유 프레임(읽기 전용 파일 페이지)은 쓸 것이 없음 */
+	for (size_t i = 0; i < cnt; i++)
+		ok[i] = pages[i] == NULL || victims[i]->share != NULL
+			|| swap_out(pages[i]);		/* == p->operations->swap_out(p) */
 
 	/* 매핑 제거와 연결 해제는 여기서 통일 처리(핸들러는 파일/디스크 I/O만 하도록) */
-	if (victim->pml4 && p && p->va)
-		pml4_clear_page(victim->pml4, p->va);
-	
-	p->frame = NULL;
-	victim->page = NULL;
-	victim->pml4 = NULL;
+	lock_acquire(&frame_lock);
+	size_t done = 0;
+	for (size_t i = 0; i < cnt; i++) {
+		struct frame *victim = victims[i];
+		victim->evicting = false;
+		if (!ok[i]) {
+			rmap_restore_ptes(victim);
+			list_push_back(&frame_table, &victim->elem);
+			continue;
+		}
+		if (pages[i] != NULL) {
+			evict_cnt++;
+			share_drop(victim);
+			rmap_unmap_all(victim);
+		}
+		victims[done++] = victim;
+	}
+	cond_broadcast(&evict_cond, &frame_lock);
+	lock_release(&frame_lock);
+	return done;
+}
 
-	/* 핵심 포인트: swap_out()은 백스토어 I/O만 담당시키고, 
-	 * PTE 해제(pml4_clear_page)와 연결 끊기는 vm_evict_frame()에서 일괄 처리.
-	 * (mmap의 do_munmap()처럼 “명시적 언매핑”은 그 루틴 안에서 clear하는 게 맞고) */
+/* PAGE의 프레임이 퇴출 배치에 들어 있으면 그 배치가 끝날 때까지 기다림. frame_lock을 잡은 채로 호출.
+ * 돌아오면 page->frame은 NULL(퇴출됨)이거나 내보내기 실패로 되살아난 매핑 */
+static void
+vm_wait_evicting (struct page *page) {
+	ASSERT (lock_held_by_current_thread (&frame_lock));
+	while (page->frame != NULL && page->frame->evicting)
+		cond_wait (&evict_cond, &frame_lock);
+}
 
-	lock_release(&frame_lock);
+/* Evict one page and return the corresponding frame.
+ * Return NULL on error.*/
+static struct frame *
+vm_evict_frame (void) {
+	/* 예비가 빈 폴트 스레드의 동기 경로: 한 장만 내보냄 */
+	struct frame *victim;
+	if (vm_evict_batch(&victim, 1) == 0)
+		return NULL;		/* 퇴출할 프레임이 없음(또는 스왑 가득) -> 폴트한 프로세스만 종료됨 */
 	return victim;		/* victim->kva를 재사용해서 반환 */
 }
 
-/* palloc()으로 유저 풀에서 프레임 1개를 확보해 frame 객체를 리턴
- * 실패하면 퇴출
- */
+/* 빈 프레임을 예비 목록에 넣음. reserve_lock을 잡은 채로 호출 */
+static void
+reserve_push (struct frame *frame) {
+	ASSERT (lock_held_by_current_thread (&reserve_lock));
+	ASSERT (list_empty (&frame->rmap) && frame->share == NULL);
+	list_push_back (&frame_reserve, &frame->elem);
+	reserve_cnt++;
+}
+
+/* 빈 프레임 하나를 예비 목록으로 반납 */
+static void
+reserve_put (struct frame *frame) {
+	lock_acquire (&reserve_lock);
+	reserve_push (frame);
+	lock_release (&reserve_lock);
+}
+
+/* 유저 풀이 바닥났고 예비가 RESERVE_LOW 아래면 데몬을 깨움. reserve_lock을 잡은 채로 호출 */
+static void
+pageout_kick (void) {
+	ASSERT (lock_held_by_current_thread (&reserve_lock));
+	if (user_pool_empty && reserve_cnt < RESERVE_LOW && !pageout_pending) {
+		pageout_pending = true;
+		sema_up (&pageout_sema);
+	}
+}
+
+/* page-out 데몬: 깨어나면 예비가 RESERVE_HIGH가 될 때까지 EVICT_BATCH개씩 묶어 퇴출해서 채움.
+ * 묶음을 쓰는 동안에도 예비 목록은 reserve_lock만으로 꺼낼 수 있으므로 폴트 스레드는 막히지 않음 */
+static void
+pageout_daemon (void *aux UNUSED) {
+	struct frame *batch[EVICT_BATCH];
+
+	for (;;) {
+		sema_down (&pageout_sema);
+		for (;;) {
+			lock_acquire (&reserve_lock);
+			size_t want = reserve_cnt < RESERVE_HIGH ? RESERVE_HIGH - reserve_cnt : 0;
+			if (want == 0)
+				pageout_pending = false;
+			lock_release (&reserve_lock);
+			if (want == 0)
+				break;
+
+			size_t cnt = vm_evict_batch (batch, want < EVICT_BATCH ? want : EVICT_BATCH);
+			lock_acquire (&reserve_lock);
+			for (size_t i = 0; i < cnt; i++)
+				reserve_push (batch[i]);
+			if (cnt == 0)		/* 더 내보낼 페이지가 없음 */
+				pageout_pending = false;
+			lock_release (&reserve_lock);
+			if (cnt == 0)
+				break;
+		}
+	}
+}
+
+/* PAGE가 가진 프레임을 떼어내 예비 목록으로 반납(없으면 무시).
+ * 페이지 파괴/언매핑 시 사용. 퇴출과 겹치지 않도록 frame_lock 아래에서 확인함 */
+void
+vm_release_frame (struct page *page) {
+	lock_acquire (&frame_lock);
+	vm_wait_evicting (page);
+	struct frame *fr = page->frame;
+	/* 내 매핑만 걷고, 마지막 매핑이었을 때만 프레임 반납 (공유 프레임이면 다른 프로세스가 계속 씀) */
+	if (fr != NULL && rmap_remove (page)) {
+		share_drop (fr);
+		list_remove (&fr->elem);
+		reserve_put (fr);
+	}
+	lock_release (&frame_lock);
+}
+
+/* 프레임 1개를 확보해 리턴: 예비 목록 -> 유저 풀(palloc) -> 직접 퇴출 순.
+ * 돌려준 프레임은 어느 목록에도 없고, vm_do_claim_page()가 내용을 채운 뒤 frame_table에 넣음 */
 static struct frame *
 vm_get_frame (void) {
+	struct frame *frame = NULL;
+
+	lock_acquire (&reserve_lock);
+	if (!list_empty (&frame_reserve)) {
+		frame = list_entry (list_pop_front (&frame_reserve), struct frame, elem);
+		reserve_cnt--;
+		pageout_kick ();
+	}
+	lock_release (&reserve_lock);
+	if (frame != NULL)
+		return frame;
+
 	void *kva = palloc_get_page (PAL_USER);	/* 유저 풀에서 물리 페이지 1장 할당 */
 	if (kva == NULL) {
+		/* 예비도 풀도 비었음: 데몬을 깨우고 이번 한 장은 직접 퇴출 */
+		lock_acquire (&reserve_lock);
+		user_pool_empty = true;
+		pageout_kick ();
+		lock_release (&reserve_lock);
 		return vm_evict_frame(); 			/* 희생 프레임을 비워서 재사용 */
 	}
 
-	struct frame *frame = malloc (sizeof *frame);
+	frame = malloc (sizeof *frame);
 	ASSERT (frame != NULL);
 
 	frame->kva = kva;		/* 커널 가상주소 기록 */
-	frame->page = NULL;		/* 아직 소유 page 없음 */
-	frame->pml4 = NULL;
-
-	lock_acquire(&frame_lock);
-	list_push_back(&frame_table, & frame->elem);
-	lock_release(&frame_lock);
-
+	list_init (&frame->rmap);	/* 아직 매핑한 page 없음 */
+	frame->share = NULL;
+	frame->pinned = false;
+	frame->evicting = false;
 	return frame;
 }
 
@@ -288,6 +723,16 @@ vm_get_frame (void) {
 #define MAX_STACK_BYTES   (1 << 20)           /* 1MB 제한 */
 #define RSP_SLACK_BYTES   8                   /* PUSH가 미리 체크하는 여유범위 */
 
+/* [START, END)를 새 영역(mmap)에 쓸 수 있는지: 기존 영역이나 스택이 자랄 자리와 겹치면 안 됨.
+ * 페이지를 하나씩 보지 않고 영역 트리로 O(log 영역 수)에 판단 */
+bool
+spt_range_free (struct supplemental_page_table *spt, void *start, void *end) {
+	uint8_t *stack_limit = (uint8_t *) USER_STACK - MAX_STACK_BYTES;
+	if ((uint8_t *) end > stack_limit && (uint8_t *) start < (uint8_t *) USER_STACK)
+		return false;
+	return !vma_overlaps (&spt->vmas, start, end);
+}
+
 static void
 vm_stack_growth (void *addr) {
 	struct thread *t = thread_current();
@@ -339,38 +784,208 @@ should_grow_stack (struct intr_frame *f, void *addr, bool user, bool write) {
 	return true;
 }
 
+/* 폴트 처리에 디스크(스왑/파일) 읽기가 필요한지: major/minor 구분용 */
+static bool
+fault_needs_io (struct page *page) {
+	if (share_cached (page))
+		return false;							/* 다른 프로세스가 이미 읽어 둔 실행 파일 페이지 */
+	switch (VM_TYPE (page->operations->type)) {
+		case VM_UNINIT:
+			return page->uninit.aux != NULL;	/* 파일 lazy 로드 */
+		case VM_ANON:
+			return page->anon.swap_slot != SIZE_MAX
+				&& !zswap_contains (page->anon.swap_slot)	/* 압축 풀/스왑 캐시 적중은 I/O 없음 */
+				&& !swap_cached (page->anon.swap_slot);
+		default:
+			return true;						/* 파일 페이지는 다시 읽어옴 */
+	}
+}
+
+/* UPAGE가 등록된 영역 안이면 그 페이지의 struct page를 지금 만들어 SPT에 넣고 리턴.
+ * 영역 밖이거나 메모리가 모자라면 NULL */
+static struct page *
+spt_page_from_vma (struct supplemental_page_table *spt, void *upage) {
+	struct vma *vma = vma_find (&spt->vmas, upage);
+	if (vma == NULL)
+		return NULL;
+
+	struct file_lazy_aux *aux = NULL;
+	if (vma->file != NULL) {
+		size_t delta = (uint8_t *) upage - (uint8_t *) vma->start;
+		aux = malloc (sizeof *aux);
+		if (aux == NULL)
+			return NULL;
+		aux->file = vma->file;
+		aux->ofs = vma->ofs + delta;
+		aux->read_bytes = delta < vma->file_bytes ? vma->file_bytes - delta : 0;
+		if (aux->read_bytes > PGSIZE)
+			aux->read_bytes = PGSIZE;
+		aux->zero_bytes = PGSIZE - aux->read_bytes;
+	}
+	if (!vm_alloc_page_with_initializer (vma->type, upage, vma->writable, vma->init, aux)) {
+		free (aux);
+		return NULL;
+	}
+	return spt_find_page (spt, upage);
+}
+
+/* 파일에서 내용을 읽어 오는 페이지인지: lazy 로드 전이거나 파일 백드 페이지 */
+static bool
+page_reads_file (struct page *page) {
+	enum vm_type type = VM_TYPE (page->operations->type);
+	return (type == VM_UNINIT && page->uninit.aux != NULL) || type == VM_FILE;
+}
+
+/* 빈 프레임이 넉넉한지(락 없이 읽는 힌트): fault-around가 퇴출을 부르면 안 되므로 */
+static bool
+frames_plentiful (void) {
+	return !user_pool_empty || reserve_cnt > RESERVE_LOW;
+}
+
+/* UPAGE의 파일 폴트를 처리한 뒤 이어지는 페이지들을 미리 들여와 매핑 (fault-around).
+ * 직전 창 바로 다음에서 폴트가 났으면 순차 접근으로 보고 창을 두 배로, 아니면 절반으로.
+ * 미리 들인 페이지는 accessed가 꺼진 채 매핑되므로 안 쓰이면 먼저 퇴출된다.
+ * 이미 올라와 있거나 파일 페이지가 아닌 곳에서 멈춤 */
+static void
+vm_fault_around (struct supplemental_page_table *spt, void *upage) {
+	if (spt->fa_next != NULL) {
+		if (upage == spt->fa_next)
+			spt->fa_window = spt->fa_window > 0 ? spt->fa_window * 2 : 1;
+		else
+			spt->fa_window /= 2;
+	}
+	if (spt->fa_window > fault_around_max)
+		spt->fa_window = fault_around_max;
+
+	uint8_t *va = (uint8_t *) upage + PGSIZE;
+	for (unsigned i = 0; i < spt->fa_window; i++, va += PGSIZE) {
+		if (!is_user_vaddr (va) || !frames_plentiful ())
+			break;
+		struct page *p = spt_find_page (spt, va);
+		if (p == NULL)
+			p = spt_page_from_vma (spt, va);
+		if (p == NULL || p->frame != NULL || p->zero_mapped || !page_reads_file (p)
+				|| page_is_untouched_zero (p))
+			break;
+		if (!vm_do_claim_page (p))
+			break;
+		spt->stats.fault_around_pages++;
+	}
+	spt->fa_next = va;
+}
+
+/* PAGE가 퇴출 배치에 들어 있으면 끝날 때까지 기다림 (그 프레임을 쓰는 폴트만 여기서 막힘).
+ * 내보내기에 실패해 PAGE가 그대로 매핑돼 있으면 true: 폴트를 더 처리할 필요 없음 */
+static bool
+vm_wait_eviction (struct page *page) {
+	lock_acquire (&frame_lock);
+	vm_wait_evicting (page);
+	bool mapped = page->frame != NULL
+		&& pml4_get_page (thread_current ()->pml4, page->va) != NULL;
+	lock_release (&frame_lock);
+	return mapped;
+}
+
+/* 한 번도 쓰인 적 없는 제로필 익명 페이지인지: 읽기 폴트를 제로 페이지로 처리할 대상.
+ * 실행 파일의 BSS처럼 파일에서 읽을 게 없는 쓰기 가능 세그먼트 페이지도 포함 */
+static bool
+page_is_untouched_zero (struct page *page) {
+	if (page->operations->type != VM_UNINIT
+			|| VM_TYPE (page->uninit.type) != VM_ANON)
+		return false;
+	if (page->uninit.init == anon_init_zero)
+		return true;
+	const struct file_lazy_aux *aux = page->uninit.aux;
+	return page->uninit.init == lazy_load_segment
+		&& aux != NULL && aux->read_bytes == 0;
+}
+
+/* PAGE를 공유 제로 페이지에 읽기 전용으로 매핑 (프레임 할당 없음) */
+static bool
+vm_map_zero_page (struct page *page) {
+	if (!pml4_set_page (thread_current ()->pml4, page->va, zero_kva, false))
+		return false;
+	page->zero_mapped = true;
+	return true;
+}
+
+/* 제로 페이지 매핑을 걷어냄. pml4_destroy()가 매핑된 페이지를 해제하므로
+ * 페이지를 없애기 전에 반드시 호출해야 함 (현재 스레드의 SPT만 대상) */
+static void
+vm_unmap_zero_page (struct page *page) {
+	if (!page->zero_mapped)
+		return;
+	pml4_clear_page (thread_current ()->pml4, page->va);
+	page->zero_mapped = false;
+}
+
 /* Handle the fault on write_protected page */
+/* 제로 페이지에 매핑된 페이지의 첫 쓰기: 매핑을 걷고 개인 프레임을 받아 제로필 */
 static bool
-vm_handle_wp (struct page *page UNUSED) {
-	/* R/W 보호 위반 대응(추후 COW에서 사용). 지금은 미구현 */
-	return false;
+vm_handle_wp (struct page *page) {
+	if (!page->zero_mapped || !page->writable)
+		return false;
+	vm_unmap_zero_page (page);
+	return vm_do_claim_page (page);
 }
 
 /* 폴트 처리 진입부
  * - not_present = 1 이고
  * - 해당 VA가 SPT에 등록되어 있으면
  *   → 프레임 할당 + swap_in/uninit-init + 매핑까지 수행 */
-bool
-vm_try_handle_fault (struct intr_frame *f, void *addr, bool user, bool write, bool not_present) {
+static bool
+handle_fault (struct intr_frame *f, void *addr, bool user, bool write, bool not_present) {
 	if (addr == NULL || !is_user_vaddr (addr))
 		return false;
 
-	/* present인데 write 폴트면 WP 처리 후보(나중에 COW에서) */
+	/* present인데 write 폴트면 WP 처리 후보: 제로 페이지의 첫 쓰기 */
 	if (!not_present) {
-		return false;
+		struct page *page = spt_find_page (&thread_current ()->spt, addr);
+		if (!write || page == NULL || !vm_handle_wp (page))
+			return false;
+		page->spt->stats.minor_faults++;
+		return true;
 	}
 
 	/* 페이지 경계로 내림 -> 그 VA로 SPT 조회 */
 	void *upage = pg_round_down (addr);
 	struct supplemental_page_table *spt = &thread_current ()->spt;
 
-	/* 1) SPT에 등록된 페이지면: 권한 체크 후 클레임 */
+	/* 1) SPT에 등록된 페이지면: 권한 체크 후 클레임 (영역 안의 첫 폴트면 여기서 페이지를 만듦) */
 	struct page *page = spt_find_page (spt, upage);
+	if (page == NULL)
+		page = spt_page_from_vma (spt, upage);
 	if (page) {
 		/* 쓰기 폴트인데 페이지가 읽기전용이면 거절 */
 		if (write && !page->writable) return false;
+		/* 퇴출 중이라 PTE만 걷혀 있던 페이지: 끝날 때까지 기다리고, 되살아났으면 끝 */
+		if (vm_wait_eviction (page)) {
+			spt->stats.minor_faults++;
+			return true;
+		}
+		/* 제로 페이지가 이미 매핑돼 있음(copy_out 등 커널 경로): 쓰기면 개인 프레임으로 */
+		if (page->zero_mapped)
+			return write ? vm_handle_wp (page) : true;
+		/* 안 쓰인 익명 페이지의 읽기: 프레임 없이 제로 페이지만 매핑 */
+		if (!write && page_is_untouched_zero (page)) {
+			if (!vm_map_zero_page (page))
+				return false;
+			spt->stats.minor_faults++;
+			return true;
+		}
 		/* 실제로 메모리에 들여와 매핑 */
-		return vm_do_claim_page (page);
+		bool major = fault_needs_io (page);
+		bool from_file = page_reads_file (page);
+		if (!vm_do_claim_page (page))
+			return false;
+		if (major)
+			spt->stats.major_faults++;
+		else
+			spt->stats.minor_faults++;
+		/* 파일에서 읽었으면 이웃 페이지도 같이 (다음 폴트를 미리 처리) */
+		if (from_file && fault_around_max > 0)
+			vm_fault_around (spt, upage);
+		return true;
 	}
 
 	/* 2) 등록된 페이지가 없고 "스택 성장 후보"라면: 성장 시도 */
@@ -378,13 +993,26 @@ vm_try_handle_fault (struct intr_frame *f, void *addr, bool user, bool write, bo
 		vm_stack_growth(addr);
 		/* 성장 후엔 해당 페이지가 매핑됐는지 확인(성장 실패 가능성 고려) */
 		page = spt_find_page(spt, upage);
-		return page && page->frame != NULL;
+		if (page == NULL || page->frame == NULL)
+			return false;
+		spt->stats.stack_faults++;
+		return true;
 	}
 
 	/* 3) 그 외는 잘못된 접근 */
 	return false;	
 }
 
+/* Return true on success.
+ * handle_fault() 앞뒤로 FAULT/FAULT_DONE 이벤트를 남겨 폴트 지연을 잴 수 있게 함 */
+bool
+vm_try_handle_fault (struct intr_frame *f, void *addr, bool user, bool write, bool not_present) {
+	TRACE (TRACE_FAULT, addr, write, user);
+	bool success = handle_fault (f, addr, user, write, not_present);
+	TRACE (TRACE_FAULT_DONE, addr, success, 0);
+	return success;
+}
+
 /* Free the page.
  * DO NOT MODIFY THIS FUNCTION. */
 void
@@ -407,30 +1035,30 @@ vm_claim_page (void *va) {
 /* Claim the PAGE and set up the mmu. */
 static bool
 vm_do_claim_page (struct page *page) {
+	/* 실행 파일 읽기 전용 페이지면 이미 올라와 있는 공유 프레임부터 찾음 */
+	struct share key;
+	bool shareable = share_key (page, &key);
+	if (shareable && vm_claim_shared (page, &key))
+		return true;
+
 	/* 프레임(물리 페이지) 하나 확보 */
 	struct frame *frame = vm_get_frame ();
 	if (frame == NULL) return false;
 
-	/* 연결(서로 역참조) */
-	frame->page = page;
-	page->frame = frame;
+	/* 연결(서로 역참조). 아직 어느 목록에도 없는 프레임이라 락 없이 */
+	rmap_add (frame, page);
 
 	/* TODO: 페이지의 가상 주소(VA)를 프레임의 물리 주소(PA)에 매핑하도록 페이지 테이블 엔트리를 삽입. */
 
 	/* PML4에 VA->KVA 매핑 설치(유저 쓰기 권한 반영) */
 	if (!pml4_set_page (thread_current ()->pml4, 
 						page->va, frame->kva, page->writable)) {
-		/* 매핑 실패 시 프레임 반납 */
-		page->frame = NULL;
-		frame->page = NULL;
-		palloc_free_page (frame->kva);
-		free (frame);
+		/* 매핑 실패 시 프레임을 예비 목록으로 반납 */
+		rmap_remove (page);
+		reserve_put (frame);
 		return false;
 	}
 
-	frame->pml4 = thread_current()->pml4;	/* 페이지 클레임 시 프레임<->pml4 연결
-											 * dirty/accessed 주인 기록 */
-
 	/* 실제 콘텐츠 채우기:
 	   - UNINIT: init()을 통해 실제 타입으로 전환 후 내용 적재
 	   - ANON : swap에서 끌어오거나(초기엔 zero-fill)
@@ -438,27 +1066,169 @@ vm_do_claim_page (struct page *page) {
 	*/
 	if (!swap_in (page, frame->kva)) {
 		/* 실패 시 매핑 해제 + 프레임 반납 */
-		pml4_clear_page (thread_current ()->pml4, page->va);
-		page->frame = NULL;
-		frame->page = NULL;
-		palloc_free_page (frame->kva);
-		free (frame);
+		rmap_remove (page);
+		reserve_put (frame);
 		return false;
 	}
+
+	/* 내용이 다 채워진 뒤에야 퇴출 후보로 등록 (공유 대상이면 다른 프로세스도 쓰도록 공개) */
+	lock_acquire (&frame_lock);
+	list_push_back (&frame_table, &frame->elem);
+	if (shareable)
+		share_publish (&key, frame);
+	lock_release (&frame_lock);
+
+	/* 상주 페이지 수와 최대치(peak RSS) 갱신 */
+	struct vm_stats *st = &page->spt->stats;
+	if (++st->resident_pages > st->peak_resident)
+		st->peak_resident = st->resident_pages;
 	return true;
 }
 
+/* PAGE를 KEY의 공유 프레임에 읽기 전용으로 매핑. 공유 프레임이 없으면 false.
+ * 아직 UNINIT이면 파일을 읽지 않고 파일 페이지로만 전환한다 */
+static bool
+vm_claim_shared (struct page *page, struct share *key) {
+	lock_acquire (&frame_lock);
+	struct share *sh;
+	/* 퇴출 중인 공유 프레임엔 붙지 않음: 끝나면 항목이 없어지거나(퇴출) 그대로 남음(실패) */
+	while ((sh = share_lookup (key)) != NULL && sh->frame->evicting)
+		cond_wait (&evict_cond, &frame_lock);
+	if (sh == NULL || !pml4_set_page (thread_current ()->pml4,
+				page->va, sh->frame->kva, false)) {
+		lock_release (&frame_lock);
+		return false;
+	}
+	/* 락 안에서 전환: 풀자마자 퇴출되더라도 페이지는 온전한 파일 페이지로 남음 */
+	if (page->operations->type == VM_UNINIT) {
+		struct uninit_page *u = &page->uninit;
+		struct file_lazy_aux *aux = u->aux;		/* page_initializer가 union을 덮기 전에 */
+		u->page_initializer (page, u->type, sh->frame->kva);
+		page->file.file = aux->file;
+		page->file.ofs = aux->ofs;
+		page->file.read_bytes = aux->read_bytes;
+		page->file.zero_bytes = aux->zero_bytes;
+		page->file.shareable = true;
+		free (aux);
+	}
+	rmap_add (sh->frame, page);
+	lock_release (&frame_lock);
+
+	struct vm_stats *st = &page->spt->stats;
+	if (++st->resident_pages > st->peak_resident)
+		st->peak_resident = st->resident_pages;
+	return true;
+}
+
+/* PAGE가 프레임을 잃을 때(퇴출/제거) 상주 페이지 수 감소 */
+void
+vm_stat_unresident (struct page *page) {
+	if (page->spt->stats.resident_pages > 0)
+		page->spt->stats.resident_pages--;
+}
+
+/* 전역 VM 통계: 퇴출 횟수, 빈 프레임 수(유저 풀 여유 + 예비 목록), 스왑/압축 풀 사용량 */
+void
+vm_get_stats (struct sys_stats *st) {
+	size_t empty;
+
+	lock_acquire (&reserve_lock);
+	empty = reserve_cnt;
+	lock_release (&reserve_lock);
+	lock_acquire (&frame_lock);
+	st->evictions = evict_cnt;
+	lock_release (&frame_lock);
+
+	st->free_frames = palloc_free_cnt (PAL_USER) + empty;
+	swap_get_stats (st);
+	zswap_get_stats (st);
+}
+
+/* -vmstat 요약: 종료하는 프로세스의 폴트/스왑/RSS 통계 */
+void
+vm_print_stats (const struct supplemental_page_table *spt) {
+	const struct vm_stats *st = &spt->stats;
+	printf ("%s: vm: %"PRIu64" minor, %"PRIu64" major, %"PRIu64" stack faults, "
+			"%"PRIu64" evictions, %"PRIu64" swap ins, %"PRIu64" swap outs, "
+			"peak RSS %"PRIu64" pages, swap cache %"PRIu64"/%"PRIu64" hits, "
+			"%"PRIu64" zswap hits, %"PRIu64" fault-around\n",
+			thread_name (), st->minor_faults, st->major_faults,
+			st->stack_faults, st->evictions, st->swap_ins, st->swap_outs,
+			st->peak_resident, st->swap_cache_hits, st->readahead_pages,
+			st->zswap_hits, st->fault_around_pages);
+}
+
 /* ---------- SPT 생명주기 ---------- */
 
 /* SPT 초기화: 해시 테이블 준비 */
 void
 supplemental_page_table_init (struct supplemental_page_table *spt) {
 	hash_init (&spt->pages, page_hash, page_less, NULL);
+	vma_tree_init (&spt->vmas);
+	rwlock_init (&spt->lock);
+	memset (&spt->stats, 0, sizeof spt->stats);
+	swap_cursor_init (&spt->swap_cursor);
+	spt->fa_next = NULL;
+	spt->fa_window = FAULT_AROUND_INIT;
 }
 
+/* SRC의 모든 페이지를 DST로 복제 (fork). 순회 중 SRC가 바뀌지 않도록 read lock */
 bool
 supplemental_page_table_copy (struct supplemental_page_table *dst,
 		struct supplemental_page_table *src) {
+	rwlock_acquire_read (&src->lock);
+	bool ok = vma_tree_copy (&dst->vmas, &src->vmas) && spt_copy_pages (dst, src);
+	rwlock_release_read (&src->lock);
+	return ok;
+}
+
+/* PAGE가 프레임에 올라와 있으면 그 프레임을 퇴출 대상에서 빼고(pin) 리턴, 아니면 NULL.
+ * 진행 중인 퇴출이 있으면 끝날 때까지 기다리므로, 여기서 본 page->frame은 확정된 상태 */
+struct frame *
+vm_pin_frame (struct page *page) {
+	lock_acquire (&frame_lock);
+	vm_wait_evicting (page);
+	struct frame *frame = page->frame;
+	if (frame != NULL)
+		frame->pinned = true;
+	lock_release (&frame_lock);
+	return frame;
+}
+
+void
+vm_unpin_frame (struct frame *frame) {
+	lock_acquire (&frame_lock);
+	frame->pinned = false;
+	lock_release (&frame_lock);
+}
+
+/* fork: 자식 PAGE를 프레임에 올리고 pin해서 리턴 (내용을 다 채울 때까지 데몬이 못 가져가게).
+ * 클레임 직후 pin 전에 퇴출됐으면 다시 클레임 */
+static struct frame *
+vm_claim_pinned (struct page *page) {
+	struct frame *frame;
+	while ((frame = vm_pin_frame (page)) == NULL)
+		if (!vm_do_claim_page (page))
+			return NULL;
+	return frame;
+}
+
+/* SRC가 프레임에 올라와 있으면 그 내용을 KVA로 복사하고 true.
+ * 복사 도중 page-out 데몬이 그 프레임을 가져가 재사용하지 못하도록 pin.
+ * 이미 퇴출됐으면 false: 호출자가 백스토어에서 읽는다 (부모는 fork 동안 멈춰 있어 그대로 유지됨) */
+static bool
+copy_resident (struct page *src, void *kva) {
+	struct frame *frame = vm_pin_frame (src);
+	if (frame == NULL)
+		return false;
+	copy_page (kva, frame->kva);
+	vm_unpin_frame (frame);
+	return true;
+}
+
+static bool
+spt_copy_pages (struct supplemental_page_table *dst,
+		struct supplemental_page_table *src) {
 	/* TODO: src를 순회하며:
 	   - UNINIT  : 같은 init/aux로 예약만 복제
 	   - ANON    : 새 anon 페이지를 만들고 내용을 복사(또는 lazy COW)
@@ -475,6 +1245,13 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 		bool writable = src_page->writable;
         enum vm_type type = page_get_type(src_page);
 
+		/* 0) 영역에서 아직 파일 내용 그대로인 페이지: 자식도 같은 영역을 받았으니
+		 *    첫 폴트 때 거기서 다시 만들면 됨 (공유 가능한 실행 파일 페이지도 마찬가지) */
+		if ((src_page->operations->type == VM_UNINIT
+				|| (type == VM_FILE && src_page->file.shareable))
+				&& vma_find (&src->vmas, va) != NULL)
+			continue;
+
 		/* 1) 소스가 아직 UNINIT인 경우 -> lazy 상태 그대로 복제 */
 		if (src_page->operations->type == VM_UNINIT) {
 			vm_initializer *init = src_page->uninit.init;	/* 최초 fault 시 호출될 초기화자 그대로 사용 */
@@ -486,9 +1263,9 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 				struct file_lazy_aux *daux = malloc(sizeof *daux);
 				if (!daux) return false;
 
-				lock_acquire(&fs_lock);
+				rwlock_acquire_write (&fs_lock);
 				daux->file = file_reopen(saux->file); 		/* 파일 핸들 분리: 파일 위치/수명 독립 */
-				lock_release(&fs_lock);
+				rwlock_release_write (&fs_lock);
 				if (!daux->file) {
 					free(daux);
 					return false;
@@ -507,9 +1284,9 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 			if (!vm_alloc_page_with_initializer(type, va, writable, init, aux)) {
 				if (aux) {			/* 실패 시 자원 정리 */
 					struct file_lazy_aux *daux = aux;		
-					lock_acquire(&fs_lock);
+					rwlock_acquire_write (&fs_lock);
 					file_close(daux->file);
-					lock_release(&fs_lock);
+					rwlock_release_write (&fs_lock);
 
 					free(daux);
 				}
@@ -525,34 +1302,57 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 			/* 자식에도 "새로운" ANON 페이지를 만들고 -> 즉시 클레임 -> 바이트 단위 복사 */
 			if (!vm_alloc_page_with_initializer(VM_ANON, va, writable, NULL, NULL))
 				return false;
-			if (!vm_claim_page(va))
-				return false;
 
-			struct page *dst_page = spt_find_page(dst, va); 	/* 자식 페이지(프레임 보유) */
-			ASSERT(dst_page && dst_page->frame);
+			struct page *dst_page = spt_find_page(dst, va); 	/* 자식 페이지 */
+			ASSERT(dst_page);
+			struct frame *dst_frame = vm_claim_pinned(dst_page);	/* 채우는 동안 퇴출 금지 */
+			if (dst_frame == NULL)
+				return false;
 
-			if (src_page->frame) {
-				memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);		/* KVA <-> KVA 복사(가장 안전) */
-			} else {
+			if (!copy_resident (src_page, dst_frame->kva)) {
 				/* 부모가 스왑에 밀려난 경우: 슬롯에서 '읽기만' 해서 자식 KVA 채우기 */
 				size_t slot = src_page->anon.swap_slot;
 				if (slot == SIZE_MAX) {
 					/* 극히 드문 케이스: 프레임도 없고 슬롯도 없음 -> 제로로 간주 */
-					memset(dst_page->frame->kva, 0, PGSIZE);
-				} else {
-					/* 스왑 디스크에서 읽어오기 (슬롯은 그대로 유지) */
-					struct disk *sd = disk_get(1, 1);
-					size_t sectors = PGSIZE / DISK_SECTOR_SIZE; /* 8 */
-					for (size_t i = 0; i < sectors; i++) {
-						disk_read(sd, slot * sectors + i,
-								  (uint8_t *)dst_page->frame->kva + i * DISK_SECTOR_SIZE);
-					}
+					clear_page(dst_frame->kva);
+				} else if (!zswap_peek(slot, dst_frame->kva)) {
+					/* 압축 풀에 없으면 스왑 디스크에서 읽어오기 (슬롯은 그대로 유지) */
+					swap_read(slot, dst_frame->kva);
 				}
 			}
+			vm_unpin_frame(dst_frame);
 			
 			continue;
 		}
 
+		if (type == VM_FILE && src_page->file.shareable) {
+			/* 실행 파일의 읽기 전용 페이지: 복사하지 않고 lazy로 예약만 해 두면
+			 * 첫 폴트 때 부모와 같은 공유 프레임에 붙는다 */
+			struct file_page *fp = &src_page->file;
+			struct file_lazy_aux *daux = malloc(sizeof *daux);
+			if (!daux) return false;
+
+			rwlock_acquire_write (&fs_lock);
+			daux->file = file_reopen(fp->file);
+			rwlock_release_write (&fs_lock);
+			if (!daux->file) {
+				free(daux);
+				return false;
+			}
+			daux->ofs = fp->ofs;
+			daux->read_bytes = fp->read_bytes;
+			daux->zero_bytes = fp->zero_bytes;
+
+			if (!vm_alloc_page_with_initializer(VM_FILE, va, writable, lazy_load_segment, daux)) {
+				rwlock_acquire_write (&fs_lock);
+				file_close(daux->file);
+				rwlock_release_write (&fs_lock);
+				free(daux);
+				return false;
+			}
+			continue;
+		}
+
 		if (type == VM_FILE) {
 			/* 이미 로드된 파일-백드 페이지.
                테스트/단계상 스왑/쓰기-회수 미구현이면, 가장 단순하고 견고한 방법은
@@ -562,25 +1362,28 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 			/* 자식은 사본 보장을 위해 ANON으로 만들어 채운다(읽기 전용이면 writable=false로 보호됨). */
 			if (!vm_alloc_page_with_initializer(VM_ANON, va, writable, NULL, NULL))
                 return false;
-            if (!vm_claim_page(va))
-                return false;
 
             struct page *dst_page = spt_find_page(dst, va);
-            ASSERT(dst_page && dst_page->frame);
+            ASSERT(dst_page);
+			struct frame *dst_frame = vm_claim_pinned(dst_page);
+			if (dst_frame == NULL)
+				return false;
 
-			if (src_page->frame) {
-				memcpy(dst_page->frame->kva, src_page->frame->kva, PGSIZE);
-			} else {
+			if (!copy_resident (src_page, dst_frame->kva)) {
 				/* 파일 메타로 원본 바이트를 읽어 채움 (write-back된 최신 상태와 일치) */
 				struct file_page *fp = &src_page->file;
-				lock_acquire(&fs_lock);
-				int n = file_read_at(fp->file, dst_page->frame->kva,
+				rwlock_acquire_read (&fs_lock);
+				int n = file_read_at(fp->file, dst_frame->kva,
 									 (int)fp->read_bytes, fp->ofs);
-				lock_release(&fs_lock);
-				if (n != (int)fp->read_bytes) return false;
+				rwlock_release_read (&fs_lock);
+				if (n != (int)fp->read_bytes) {
+					vm_unpin_frame(dst_frame);
+					return false;
+				}
 				if (fp->zero_bytes)
-					memset((uint8_t *)dst_page->frame->kva + fp->read_bytes, 0, fp->zero_bytes);
+					memset((uint8_t *)dst_frame->kva + fp->read_bytes, 0, fp->zero_bytes);
 			}
+			vm_unpin_frame(dst_frame);
             
 			continue;
 
@@ -600,6 +1403,9 @@ supplemental_page_table_copy (struct supplemental_page_table *dst,
 static void
 spt_destroy_action (struct hash_elem *e, void *aux UNUSED) {
 	struct page *p = hash_entry(e, struct page, h_elem);
+	if (p->frame)
+		vm_stat_unresident (p);
+	vm_unmap_zero_page (p);
 	vm_dealloc_page(p);
 }
 
@@ -610,7 +1416,11 @@ supplemental_page_table_kill (struct supplemental_page_table *spt) {
 
 	 /* hash_destroy는 각 원소에 대해 지정한 함수 호출 후, 해시 내부 버킷을 해제
 	  * -> 각 엔트리의 실질 정리는 spt_destroy_action -> vm_dealloc_page -> destroy(page) 로 위임. */
+	 rwlock_acquire_write (&spt->lock);
 	 hash_destroy (&spt->pages, spt_destroy_action);
+	 rwlock_release_write (&spt->lock);
+	 /* 영역은 페이지들이 파일 핸들을 다 쓴 뒤에 닫음 */
+	 vma_tree_destroy (&spt->vmas);
 }
 
 /* 위 처럼 분리하는 이유는
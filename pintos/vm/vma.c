@@ -0,0 +1,249 @@
+/* vma.c: 가상 메모리 영역 트리 (시작 주소로 정렬한 AVL 트리). */
+
+#include "vm/vm.h"
+#include "vm/vma.h"
+#include <debug.h>
+#include "filesys/file.h"
+#include "threads/malloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+
+extern struct rwlock fs_lock;
+
+void
+vma_tree_init (struct vma_tree *tree) {
+	tree->root = NULL;
+	tree->cnt = 0;
+}
+
+/* ---------- AVL 균형 ---------- */
+
+static int
+height (const struct vma *v) {
+	return v != NULL ? v->height : 0;
+}
+
+static void
+update_height (struct vma *v) {
+	int l = height (v->left), r = height (v->right);
+	v->height = 1 + (l > r ? l : r);
+}
+
+static struct vma *
+rotate_right (struct vma *y) {
+	struct vma *x = y->left;
+	y->left = x->right;
+	x->right = y;
+	update_height (y);
+	update_height (x);
+	return x;
+}
+
+static struct vma *
+rotate_left (struct vma *x) {
+	struct vma *y = x->right;
+	x->right = y->left;
+	y->left = x;
+	update_height (x);
+	update_height (y);
+	return y;
+}
+
+/* V의 높이를 갱신하고 양쪽 높이 차가 2가 되면 회전. 새 부분트리 루트를 리턴 */
+static struct vma *
+rebalance (struct vma *v) {
+	update_height (v);
+	int balance = height (v->left) - height (v->right);
+	if (balance > 1) {
+		if (height (v->left->left) < height (v->left->right))
+			v->left = rotate_left (v->left);
+		return rotate_right (v);
+	}
+	if (balance < -1) {
+		if (height (v->right->right) < height (v->right->left))
+			v->right = rotate_right (v->right);
+		return rotate_left (v);
+	}
+	return v;
+}
+
+static struct vma *
+insert (struct vma *root, struct vma *v) {
+	if (root == NULL)
+		return v;
+	if (v->start < root->start)
+		root->left = insert (root->left, v);
+	else
+		root->right = insert (root->right, v);
+	return rebalance (root);
+}
+
+/* V에서 가장 왼쪽 노드를 떼어 *MIN에 담고 남은 부분트리를 리턴 */
+static struct vma *
+remove_min (struct vma *v, struct vma **min) {
+	if (v->left == NULL) {
+		*min = v;
+		return v->right;
+	}
+	v->left = remove_min (v->left, min);
+	return rebalance (v);
+}
+
+/* START로 시작하는 노드를 떼어 *OUT에 담음 (없으면 그대로) */
+static struct vma *
+remove_node (struct vma *root, const void *start, struct vma **out) {
+	if (root == NULL)
+		return NULL;
+	if (start < root->start)
+		root->left = remove_node (root->left, start, out);
+	else if (start > root->start)
+		root->right = remove_node (root->right, start, out);
+	else {
+		*out = root;
+		if (root->left == NULL)
+			return root->right;
+		if (root->right == NULL)
+			return root->left;
+		struct vma *succ;
+		struct vma *right = remove_min (root->right, &succ);
+		succ->left = root->left;
+		succ->right = right;
+		return rebalance (succ);
+	}
+	return rebalance (root);
+}
+
+/* ---------- 영역 등록/조회 ---------- */
+
+/* V의 파일 핸들을 닫고 V를 해제 */
+static void
+vma_free (struct vma *v) {
+	if (v->file != NULL) {
+		rwlock_acquire_write (&fs_lock);
+		file_close (v->file);
+		rwlock_release_write (&fs_lock);
+	}
+	free (v);
+}
+
+/* START부터 PAGE_CNT 페이지를 영역으로 등록. FILE이 있으면 OFS부터 FILE_BYTES만큼
+ * 읽고 나머지는 0으로 채우며, 영역 전용 핸들을 reopen해서 가짐.
+ * 기존 영역과 겹치거나 메모리가 모자라면 false */
+bool
+vma_map (struct vma_tree *tree, void *start, size_t page_cnt,
+		enum vm_type type, bool writable, vm_initializer *init,
+		struct file *file, off_t ofs, size_t file_bytes) {
+	ASSERT (pg_ofs (start) == 0);
+	ASSERT (page_cnt > 0);
+
+	void *end = (uint8_t *) start + page_cnt * PGSIZE;
+	if (vma_overlaps (tree, start, end))
+		return false;
+
+	struct vma *v = malloc (sizeof *v);
+	if (v == NULL)
+		return false;
+	*v = (struct vma) {
+		.start = start,
+		.end = end,
+		.type = type,
+		.writable = writable,
+		.init = init,
+		.ofs = ofs,
+		.file_bytes = file_bytes,
+		.height = 1,
+	};
+	if (file != NULL) {
+		rwlock_acquire_write (&fs_lock);
+		v->file = file_reopen (file);
+		rwlock_release_write (&fs_lock);
+		if (v->file == NULL) {
+			free (v);
+			return false;
+		}
+	}
+
+	tree->root = insert (tree->root, v);
+	tree->cnt++;
+	return true;
+}
+
+/* VA를 포함하는 영역, 없으면 NULL */
+struct vma *
+vma_find (struct vma_tree *tree, const void *va) {
+	struct vma *v = tree->root;
+	while (v != NULL) {
+		if (va < v->start)
+			v = v->left;
+		else if (va >= v->end)
+			v = v->right;
+		else
+			return v;
+	}
+	return NULL;
+}
+
+/* [START, END)와 겹치는 영역이 있는지.
+ * 영역끼리 겹치지 않으므로 END <= v->start면 오른쪽은 모두 뒤에, START >= v->end면
+ * 왼쪽은 모두 앞에 있다: 한 갈래만 내려가면 됨 */
+bool
+vma_overlaps (struct vma_tree *tree, const void *start, const void *end) {
+	struct vma *v = tree->root;
+	while (v != NULL) {
+		if (end <= v->start)
+			v = v->left;
+		else if (start >= v->end)
+			v = v->right;
+		else
+			return true;
+	}
+	return false;
+}
+
+/* START로 시작하는 영역을 지움. 이미 만들어진 페이지는 호출자가 먼저 정리해야 함
+ * (페이지가 영역의 파일 핸들을 쓰고 있으므로) */
+void
+vma_unmap (struct vma_tree *tree, void *start) {
+	struct vma *v = NULL;
+	tree->root = remove_node (tree->root, start, &v);
+	if (v != NULL) {
+		tree->cnt--;
+		vma_free (v);
+	}
+}
+
+/* ---------- fork / 종료 ---------- */
+
+/* SRC 부분트리의 영역을 모두 DST에 등록 (파일 핸들은 새로 reopen) */
+static bool
+copy_subtree (struct vma_tree *dst, const struct vma *v) {
+	if (v == NULL)
+		return true;
+	size_t page_cnt = ((uint8_t *) v->end - (uint8_t *) v->start) / PGSIZE;
+	return vma_map (dst, v->start, page_cnt, v->type, v->writable, v->init,
+			v->file, v->ofs, v->file_bytes)
+		&& copy_subtree (dst, v->left)
+		&& copy_subtree (dst, v->right);
+}
+
+/* SRC의 영역을 DST로 복제 (fork) */
+bool
+vma_tree_copy (struct vma_tree *dst, struct vma_tree *src) {
+	return copy_subtree (dst, src->root);
+}
+
+static void
+destroy_subtree (struct vma *v) {
+	if (v == NULL)
+		return;
+	destroy_subtree (v->left);
+	destroy_subtree (v->right);
+	vma_free (v);
+}
+
+/* 모든 영역을 지움. 영역에서 만든 페이지가 먼저 없어져 있어야 함 */
+void
+vma_tree_destroy (struct vma_tree *tree) {
+	destroy_subtree (tree->root);
+	vma_tree_init (tree);
+}
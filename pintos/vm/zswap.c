@@ -0,0 +1,272 @@
+/* zswap.c: 퇴출된 익명 페이지를 압축해 메모리에 보관하는 스왑 앞단 풀. */
+
+#include "vm/zswap.h"
+#include <bitmap.h>
+#include <debug.h>
+#include <hash.h>
+#include <list.h>
+#include <lz.h>
+#include <round.h>
+#include <stats.h>
+#include <string.h>
+#include "threads/malloc.h"
+#include "threads/palloc.h"
+#include "threads/synch.h"
+#include "threads/vaddr.h"
+#include "vm/swap.h"
+
+#define ZSWAP_CHUNK 64							/* 아레나 할당 단위 (바이트) */
+#define ZSWAP_CHUNKS (PGSIZE / ZSWAP_CHUNK)		/* 아레나 페이지당 청크 수 = 64 */
+#define ZSWAP_MAX_SIZE (PGSIZE * 3 / 4)			/* 이보다 크게 압축되면 그냥 디스크로 */
+
+/* 아레나 페이지: 압축된 페이지들을 청크 단위로 나눠 담음.
+ * used의 i번째 비트가 i번째 청크 사용 여부 (ZSWAP_CHUNKS == 64) */
+struct zswap_page {
+	void *kva;					/* 커널 페이지 (NULL이면 아직 안 받음) */
+	uint64_t used;
+};
+
+/* 풀에 들어 있는 페이지 하나 */
+struct zswap_entry {
+	size_t slot;				/* 원래 스왑 슬롯 (키) */
+	struct zswap_page *zp;		/* 담긴 아레나 페이지 */
+	unsigned chunk;				/* 시작 청크 */
+	size_t size;				/* 압축된 크기 */
+	struct hash_elem h_elem;	/* entries 연결 */
+	struct list_elem lru;		/* lru 연결 (앞쪽이 오래된 것) */
+};
+
+size_t zswap_max_pages = 64;
+
+static struct zswap_page *arena;	/* zswap_max_pages 칸 */
+static size_t arena_cnt;			/* 받아 둔 아레나 페이지 수 */
+static struct hash entries;			/* 슬롯 -> 항목 */
+static struct list lru;				/* 저장 순서 = 퇴출 순서 */
+static struct bitmap *present;		/* 풀에 있는 슬롯 (락 없이 읽는 힌트) */
+static struct lock zswap_lock;		/* 아래 버퍼 포함 전부 보호. 락 순서: zswap_lock -> swap_lock */
+
+static struct lz_work work;			/* 압축 작업 공간 (스레드 스택에 두기엔 큼) */
+static void *cbuf;					/* 압축 결과 임시 버퍼 */
+static void *wbuf;					/* writeback 때 압축을 풀어 둘 페이지 */
+
+static size_t stored_cnt;			/* 풀에 있는 페이지 수 */
+static uint64_t writeback_cnt;		/* 풀이 차서 디스크로 내린 횟수 */
+
+static uint64_t
+entry_hash (const struct hash_elem *e, void *aux UNUSED) {
+	const struct zswap_entry *ze = hash_entry (e, struct zswap_entry, h_elem);
+	return hash_int (ze->slot);
+}
+
+static bool
+entry_less (const struct hash_elem *a, const struct hash_elem *b,
+			void *aux UNUSED) {
+	return hash_entry (a, struct zswap_entry, h_elem)->slot
+		< hash_entry (b, struct zswap_entry, h_elem)->slot;
+}
+
+/* 슬롯이 SLOT_CNT개인 스왑 디스크 앞에 풀을 준비 (아레나 페이지는 필요할 때 받음) */
+void
+zswap_init (size_t slot_cnt) {
+	lock_init (&zswap_lock);
+	lock_set_name (&zswap_lock, "zswap_lock");
+	hash_init (&entries, entry_hash, entry_less, NULL);
+	list_init (&lru);
+	present = bitmap_create (slot_cnt);
+	if (present == NULL) PANIC ("no zswap bitmap");
+	if (zswap_max_pages == 0)
+		return;
+
+	arena = calloc (zswap_max_pages, sizeof *arena);
+	cbuf = palloc_get_page (0);
+	wbuf = palloc_get_page (0);
+	if (arena == NULL || cbuf == NULL || wbuf == NULL)
+		zswap_max_pages = 0;		/* 메모리가 모자라면 풀 없이 동작 */
+}
+
+/* SLOT의 항목. zswap_lock을 잡은 채로 호출 */
+static struct zswap_entry *
+entry_lookup (size_t slot) {
+	struct zswap_entry key;
+	key.slot = slot;
+	struct hash_elem *e = hash_find (&entries, &key.h_elem);
+	return e != NULL ? hash_entry (e, struct zswap_entry, h_elem) : NULL;
+}
+
+/* USED에서 연속으로 빈 청크 N개의 시작 위치, 없으면 -1 */
+static int
+find_run (uint64_t used, unsigned n) {
+	uint64_t mask = ((uint64_t) 1 << n) - 1;
+	for (unsigned i = 0; i + n <= ZSWAP_CHUNKS; i++)
+		if ((used & (mask << i)) == 0)
+			return i;
+	return -1;
+}
+
+/* 청크 N개를 잡아 *ZP, *CHUNK에 기록. 기존 아레나 페이지에서 먼저 찾고,
+ * 없으면 상한 안에서 새 페이지를 받는다. zswap_lock을 잡은 채로 호출 */
+static bool
+chunk_alloc (unsigned n, struct zswap_page **zp, unsigned *chunk) {
+	struct zswap_page *empty = NULL;
+
+	for (size_t i = 0; i < zswap_max_pages; i++) {
+		struct zswap_page *p = &arena[i];
+		if (p->kva == NULL) {
+			if (empty == NULL)
+				empty = p;
+			continue;
+		}
+		int ofs = find_run (p->used, n);
+		if (ofs >= 0) {
+			*zp = p;
+			*chunk = ofs;
+			p->used |= (((uint64_t) 1 << n) - 1) << ofs;
+			return true;
+		}
+	}
+
+	if (empty == NULL || (empty->kva = palloc_get_page (0)) == NULL)
+		return false;
+	arena_cnt++;
+	*zp = empty;
+	*chunk = 0;
+	empty->used = ((uint64_t) 1 << n) - 1;
+	return true;
+}
+
+/* 항목 E를 풀에서 지움. 빈 아레나 페이지는 커널 풀로 돌려줌. zswap_lock을 잡은 채로 호출 */
+static void
+entry_free (struct zswap_entry *e) {
+	unsigned n = DIV_ROUND_UP (e->size, ZSWAP_CHUNK);
+	e->zp->used &= ~((((uint64_t) 1 << n) - 1) << e->chunk);
+	if (e->zp->used == 0) {
+		palloc_free_page (e->zp->kva);
+		e->zp->kva = NULL;
+		arena_cnt--;
+	}
+	hash_delete (&entries, &e->h_elem);
+	list_remove (&e->lru);
+	bitmap_reset (present, e->slot);
+	stored_cnt--;
+	free (e);
+}
+
+/* 항목 E의 압축을 KVA에 풂 */
+static void
+entry_decompress (const struct zswap_entry *e, void *kva) {
+	const uint8_t *src = (const uint8_t *) e->zp->kva + e->chunk * ZSWAP_CHUNK;
+	if (!lz_decompress (src, e->size, kva, PGSIZE))
+		PANIC ("zswap: corrupt entry for slot %zu", e->slot);
+}
+
+/* 가장 오래된 항목을 원래 슬롯에 기록하고 풀에서 뺌. 비어 있으면 false.
+ * 디스크 쓰기 동안 zswap_lock을 잡고 있으므로, 그 슬롯을 읽거나 반납하려는
+ * 쪽은 기록이 끝날 때까지 기다린다. zswap_lock을 잡은 채로 호출 */
+static bool
+writeback_oldest (void) {
+	if (list_empty (&lru))
+		return false;
+	struct zswap_entry *e = list_entry (list_front (&lru), struct zswap_entry, lru);
+	entry_decompress (e, wbuf);
+	swap_write (e->slot, wbuf);
+	entry_free (e);
+	writeback_cnt++;
+	return true;
+}
+
+/* KVA의 페이지를 압축해 SLOT 이름으로 풀에 넣음.
+ * 압축이 잘 안 되거나 자리를 만들 수 없으면 false: 호출자가 디스크에 쓴다 */
+bool
+zswap_store (size_t slot, const void *kva) {
+	if (zswap_max_pages == 0)
+		return false;
+
+	lock_acquire (&zswap_lock);
+	ASSERT (entry_lookup (slot) == NULL);
+	size_t size = lz_compress (kva, PGSIZE, cbuf, ZSWAP_MAX_SIZE, &work);
+	struct zswap_entry *e = size > 0 ? malloc (sizeof *e) : NULL;
+	if (e == NULL) {
+		lock_release (&zswap_lock);
+		return false;
+	}
+
+	/* 자리가 날 때까지 오래된 것부터 디스크로 */
+	unsigned n = DIV_ROUND_UP (size, ZSWAP_CHUNK);
+	while (!chunk_alloc (n, &e->zp, &e->chunk)) {
+		if (!writeback_oldest ()) {
+			lock_release (&zswap_lock);
+			free (e);
+			return false;
+		}
+	}
+
+	memcpy ((uint8_t *) e->zp->kva + e->chunk * ZSWAP_CHUNK, cbuf, size);
+	e->slot = slot;
+	e->size = size;
+	hash_insert (&entries, &e->h_elem);
+	list_push_back (&lru, &e->lru);
+	bitmap_mark (present, slot);
+	stored_cnt++;
+	lock_release (&zswap_lock);
+	return true;
+}
+
+/* SLOT이 풀에 있으면 KVA로 압축을 풀고 항목을 지운 뒤 true (디스크 I/O 없음) */
+bool
+zswap_load (size_t slot, void *kva) {
+	if (!zswap_contains (slot))
+		return false;
+
+	lock_acquire (&zswap_lock);
+	struct zswap_entry *e = entry_lookup (slot);
+	if (e != NULL) {
+		entry_decompress (e, kva);
+		entry_free (e);
+	}
+	lock_release (&zswap_lock);
+	return e != NULL;
+}
+
+/* SLOT이 풀에 있으면 KVA로 압축만 풀고 true. 항목은 그대로 둠 (fork가 부모 슬롯을 읽을 때) */
+bool
+zswap_peek (size_t slot, void *kva) {
+	if (!zswap_contains (slot))
+		return false;
+
+	lock_acquire (&zswap_lock);
+	struct zswap_entry *e = entry_lookup (slot);
+	if (e != NULL)
+		entry_decompress (e, kva);
+	lock_release (&zswap_lock);
+	return e != NULL;
+}
+
+/* 반납되는 SLOT의 항목을 버림 */
+void
+zswap_invalidate (size_t slot) {
+	if (!zswap_contains (slot))
+		return;
+
+	lock_acquire (&zswap_lock);
+	struct zswap_entry *e = entry_lookup (slot);
+	if (e != NULL)
+		entry_free (e);
+	lock_release (&zswap_lock);
+}
+
+/* SLOT이 풀에 있는지. 락 없이 읽으므로 저장/로드가 진행 중이면 틀릴 수 있음:
+ * 슬롯 주인(그 슬롯을 저장했거나 반납할 쪽)이 부를 때만 정확하다 */
+bool
+zswap_contains (size_t slot) {
+	return bitmap_test (present, slot);
+}
+
+/* 압축 풀 사용량을 ST에 기록 */
+void
+zswap_get_stats (struct sys_stats *st) {
+	lock_acquire (&zswap_lock);
+	st->zswap_stored = stored_cnt;
+	st->zswap_pool_pages = arena_cnt;
+	st->zswap_writebacks = writeback_cnt;
+	lock_release (&zswap_lock);
+}